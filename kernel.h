@@ -1,10 +1,46 @@
 /* Patrick's DEBUG printing constant... */
+#ifndef DEBUG
 #define DEBUG 1
+#endif
+
+/*
+ * Entry points halt when called in user mode, checking the PSR their
+ * irqSave() section starts with.  The few internal functions that check
+ * separately, like the dispatcher, use requireKernelMode(); the release
+ * build (make release) drops it, since they go on to
+ * disableInterrupts(), which validates the mode from the PSR anyway.
+ */
+#ifndef RELEASE
+#define RELEASE 0
+#endif
+
+#if RELEASE
+#define requireKernelMode(func) do { } while (0)
+#else
+#define requireKernelMode(func) do { \
+	if ( !isInKernelMode() ) { \
+		USLOSS_Console(func "(): called while in user mode, by process %d. Halting...\n", Current->pid); \
+		USLOSS_Halt(1); \
+	} \
+} while (0)
+#endif
+
+/* zapAsync() keeps one bit per process table slot */
+#if MAXPROC > 64
+#error "MAXPROC must fit in an unsigned long long slot mask"
+#endif
 
 typedef struct procStruct procStruct;
 
 typedef struct procStruct * procPtr;
 
+/* FIFO of blocked processes, linked through their waitNext fields */
+typedef struct waitQueue {
+   procPtr         head;
+   procPtr         tail;
+   int             count;
+} waitQueue;
+
 struct procStruct {
    procPtr         nextProcPtr;
    procPtr         childProcPtr;
@@ -25,14 +61,86 @@ struct procStruct {
    int             numJoins;
    procPtr         parentPtr;
    int             zapped;
-   procPtr         zapperList;
-   procPtr         zapperNext;
+   waitQueue       zappers;       /* processes blocked zapping this one */
+   procPtr         waitNext;      /* next process on the same wait queue */
+   procPtr         waitsFor;      /* the one process it is blocked on, if any */
+   int             irqDepth;      /* irqSave() sections it is switched out in */
    int             numLiveKids;
-   int             startTime;
-   int             totalTimeUsed;
+   long long       startTime;     /* kernel time it was last dispatched */
+   long long       totalTimeUsed;
+   long long       wakeTime;      /* deadline of a timed wait, -1 if none */
+   long long       stateSince;    /* when it last became ready or blocked */
+   long long       readyTime;     /* time spent ready but not running */
+   long long       joinBlockedTime;
+   long long       zapBlockedTime;
+   long long       meBlockedTime; /* blockMe() and sleepMe() */
+   long long       syncBlockedTime; /* waitEvent() and kernel sync objects */
+   int             dispatches;
+   int             voluntarySwitches;   /* gave up the CPU by blocking or quitting */
+   int             involuntarySwitches; /* preempted while still runnable */
+   procPtr         timerNext;     /* neighbours on the same timer wheel slot */
+   procPtr         timerPrev;
+   int             timerSlot;     /* level * WHEELSLOTS + slot of the timer */
+   int             timedOut;      /* set when the timer woke the process */
+   int             detached;      /* reaped on quit, never joined */
+   int             waitAllKids;   /* blocked in joinAll() */
+   procPtr         reapNext;      /* next dead process waiting for the reaper */
+   int             wakeEvent;     /* event that ended a waitEvent(), 0 if none */
+   unsigned long long asyncZappers; /* slots with a zapAsync() on this process */
+   unsigned long long zapTargets;   /* slots this process has zapAsync()ed */
+   int             zapDone[MAXPROC]; /* handles of completed zapAsync() calls */
+   int             numZapDone;
+   int             zapWaitMode;   /* ZAP_WAIT_ANY/ALL while in zapWait(), else 0 */
+   unsigned long long treeZappers;  /* slots waiting in zapTree() on this process */
+   int             treeZapsLeft;  /* processes of our zapTree() not yet quit */
+   int             waitResult;    /* left by whoever ends a SYNCBLOCKED wait */
+   int             basePriority;  /* priority before any inheritance */
+   int             waitMutex;     /* mutex being waited for, or -1 */
+   int             condMutex;     /* mutex to reacquire after condWait(), or -1 */
+   struct mutexStruct *heldMutexes; /* mutexes owned, linked through heldNext */
+   int            *waitAddr;      /* address waited on in blockOn(), or NULL */
+   int            *msgBuf;        /* messages of a blocked channel send/receive */
+   int             msgCount;      /* messages of msgBuf moved so far */
+   int             msgMax;        /* size of msgBuf */
    /* other fields as needed... */
 };
 
+typedef struct semStruct {
+   int             inUse;
+   int             value;
+   waitQueue       waiters;
+} semStruct;
+
+typedef struct mutexStruct {
+   int             inUse;
+   int             flags;
+   procPtr         owner;
+   waitQueue       waiters;
+   struct mutexStruct *heldNext;  /* the owner's other mutexes */
+   struct mutexStruct *heldPrev;
+} mutexStruct;
+
+typedef struct condStruct {
+   int             inUse;
+   waitQueue       waiters;
+} condStruct;
+
+typedef struct barrierStruct {
+   int             inUse;
+   int             parties;       /* processes that must arrive */
+   waitQueue       waiters;
+} barrierStruct;
+
+typedef struct chanStruct {
+   int             inUse;
+   int             capacity;
+   int             head;          /* index of the oldest queued message */
+   int             count;         /* number of queued messages */
+   int             buffer[MAXCHANSLOTS];
+   waitQueue       senders;       /* blocked only while the channel is full */
+   waitQueue       receivers;     /* blocked only while the channel is empty */
+} chanStruct;
+
 struct psrBits {
     unsigned int curMode:1;
     unsigned int curIntEnable:1;
@@ -52,12 +160,22 @@ union psrValues {
 #define MAXPRIORITY 1
 #define SENTINELPID 1
 #define SENTINELPRIORITY (MINPRIORITY + 1)
-#define EMPTY 0
-#define READY 1
-#define RUNNING 2
-#define JOINBLOCKED 3
-#define ZAPBLOCKED 4
-#define QUIT 5
-#define MEBLOCKED 10
+/* process statuses are in phase1.h */
+
+/* microseconds between clock interrupts */
+#define CLOCKTICK 20000
+
+/* idle deadline of a sentinel with no timers to wait for */
+#define IDLEFOREVER 0x7fffffffffffffffLL
+
+/* shape of the timer wheel: WHEELSLOTS^WHEELLEVELS ticks can be timed */
+#define WHEELLEVELS 3
+#define WHEELSLOTS 64
+
+/* number of hash buckets for blockOn() wait queues */
+#define ADDRBUCKETS 32
+
+/* number of dead processes queued before the reaper cleans them inline */
+#define REAPTHRESHOLD 8
 
 
@@ -14,6 +14,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <stdarg.h>
 
 #include "kernel.h"
 
@@ -27,6 +28,11 @@ int isInKernelMode();
 int isInterruptEnabled();
 int enableInterrupts();
 void disableInterrupts();
+unsigned int irqSave();
+void irqRestore(unsigned int psr);
+static unsigned int enterKernel(const char *func);
+static unsigned int psrGet();
+static int psrSet(unsigned int psr);
 int enterKernelMode();
 int enterUserMode();
 unsigned int getNextPid();
@@ -35,7 +41,42 @@ void initProcessTable();
 void initReadyLists();
 void addProcToReadyLists();
 void cleanProcess(procPtr);
+void freeDeadStack();
+void reapLater(procPtr);
+void initWaitQueue(waitQueue *queue);
+void enqueueWaiter(waitQueue *queue, procPtr proc);
+procPtr dequeueWaiter(waitQueue *queue);
+int wakeAllWaiters(waitQueue *queue);
+int waitOn(waitQueue *queue);
+procPtr wakeOne(waitQueue *queue, int result);
+int wakeAllWithResult(waitQueue *queue, int result);
+void preemptFor(int priority);
+int lockMutex(int id);
+void setMutexOwner(mutexStruct *mutex, procPtr owner);
+procPtr unlockMutex(int id);
+int moveToMutex(procPtr proc);
+void inheritPriority(procPtr owner, int priority);
+void restorePriority(procPtr proc);
+void removeWaiter(waitQueue *queue, procPtr prev, procPtr proc);
+int addrBucket(int *addr);
+int sendMessages(int id, int msgs[], int n, const char *func);
+int receiveMessages(int id, int msgs[], int max, const char *func);
+void removeProcFromReadyLists(procPtr proc);
+void setPriority(procPtr proc, int priority);
+void markZapped(procPtr proc);
+void setStatus(procPtr proc, int status);
+static void trace(int event, int pid, int arg);
+static int appendf(char *buf, int size, int *len, char *format, ...);
+static int appendName(char *buf, int size, int *len, char *name, int json);
+void makeReady(procPtr proc);
+void waitFor(procPtr target);
+static int waitsOnCurrent(procPtr target);
+static long long *blockedTimeFor(procPtr proc);
+static void resetStats(procPtr proc);
+void zapCompleted(procPtr proc, int pid);
+void reapDeadProcesses();
 void dumpProcesses();
+void dumpStatusCounts();
 int   zap(int pid);
 int   isZapped(void);
 int   getpid(void);
@@ -50,6 +91,16 @@ void illegalInstructionHandler(int dev, void *arg);
 void timeSlice(void);
 int readCurStartTime(void);
 int onReadyList(int pid, int priority);
+static int joinChild(int *status, int timeout, const char *func);
+static int blockCurrent(int block_status, int timeout, unsigned int psr);
+static long long refreshKernelTime(void);
+void armTimer(procPtr proc, long long deadline);
+void cancelTimer(procPtr proc);
+static void insertTimer(procPtr proc, int earliest);
+static void cascadeTimers(int level, int slot);
+static void advanceTimers(void);
+static long long nextTimerDeadline(void);
+static int collectChild(int *status);
 
 
 /* -------------------------- Globals ------------------------------------- */
@@ -57,6 +108,9 @@ int onReadyList(int pid, int priority);
 // Patrick's debugging global variable...
 int debugflag = 0;
 
+// print the trace ring when USLOSS halts
+int traceflag = 0;
+
 // the process table
 procStruct ProcTable[MAXPROC];
 
@@ -71,6 +125,66 @@ procPtr Current = NULL;
 // the next pid to be assigned
 unsigned int nextPid = 0;
 
+// kernel time in microseconds, accumulated from the 32 bit clock device
+// so it does not wrap, and the raw device reading it was last updated from
+static long long kernelTime = 0;
+static unsigned int lastClockReading = 0;
+
+// set when the clock interrupt has just refreshed kernelTime
+static int timeFromTick = 0;
+
+// while the sentinel idles, the time of the next tick with work to do,
+// or -1, and the time reached counting the ticks skipped until then
+static long long idleUntil = -1;
+static long long idleClock = 0;
+
+// names of the statuses below MEBLOCKED, by value
+static char *StatusNames[MEBLOCKED] = {"EMPTY", "READY", "RUNNING",
+		"JOINBLOCKED", "ZAPBLOCKED", "QUIT", "DEAD", "WAITBLOCKED",
+		"SYNCBLOCKED", "SLEEPBLOCKED"};
+
+// number of processes in each status; all the blockMe() statuses are
+// counted together under MEBLOCKED
+static int StatusCounts[MEBLOCKED + 1];
+
+// number of irqSave() sections Current is inside of
+static int irqDepth = 0;
+
+// PSR reads and writes made by the kernel
+static int psrReads = 0;
+static int psrWrites = 0;
+
+// the trace ring, and the number of events ever recorded in it
+static traceRecord TraceRing[TRACESIZE];
+static unsigned int traceCount = 0;
+
+// timer wheel for timed waits, and the last clock tick it was advanced to
+static procPtr TimerWheel[WHEELLEVELS][WHEELSLOTS];
+static int currentTick = 0;
+static int numTimers = 0;
+
+// kernel semaphores, mutexes and condition variables
+static semStruct SemTable[MAXSEMAPHORES];
+static mutexStruct MutexTable[MAXMUTEXES];
+static condStruct CondTable[MAXCONDS];
+
+// kernel message channels
+static chanStruct ChanTable[MAXCHANNELS];
+
+// kernel barriers
+static barrierStruct BarrierTable[MAXBARRIERS];
+
+// processes in blockOn, hashed by the address they wait on
+static waitQueue AddrWaiters[ADDRBUCKETS];
+
+// joined and detached processes waiting to be cleaned by the reaper
+static procPtr ReapList = NULL;
+static procPtr ReapTail = NULL;
+static int numDead = 0;
+
+// stack of a process that was cleaned while still running on it
+static char *deadStack = NULL;
+
 
 /* -------------------------- Functions ----------------------------------- */
 /* ------------------------------------------------------------------------
@@ -143,6 +257,8 @@ void finish(int argc, char *argv[])
 {
 		if (DEBUG && debugflag)
 				USLOSS_Console("in finish...\n");
+		if (traceflag)
+				dumpTrace();
 } /* finish */
 
 /* ------------------------------------------------------------------------
@@ -159,14 +275,29 @@ void finish(int argc, char *argv[])
 	 ------------------------------------------------------------------------ */
 int fork1(char *name, int (*startFunc)(char *), char *arg,
 					int stacksize, int priority)
+{
+		return fork1Flags(name, startFunc, arg, stacksize, priority, 0);
+} /* fork1 */
+
+/* ------------------------------------------------------------------------
+	 Name - fork1Flags
+	 Purpose - fork1 with creation flags.  FORK_DETACHED creates a process
+						 that is never joined: it is left off the parent's child
+						 list and its slot and stack are released as soon as it
+						 quits.
+	 Parameters - as fork1, plus the creation flags.
+	 Returns - as fork1, and -1 for flags other than FORK_DETACHED
+	 Side Effects - as fork1
+	 ------------------------------------------------------------------------ */
+int fork1Flags(char *name, int (*startFunc)(char *), char *arg,
+					int stacksize, int priority, int flags)
 {
 		// test if in kernel mode; halt if in user mode 
-		if ( !isInKernelMode() ) {
+		unsigned int psr = irqSave();
+		if ( (psr & USLOSS_PSR_CURRENT_MODE) == 0 ) {
 			USLOSS_Console("fork1(): called while in user mode, by process %d. Halting...\n", getNextPid()-1);
 			USLOSS_Halt(1);
 		}
-
-		disableInterrupts();
 		int procSlot = -1;
 
 		if (DEBUG && debugflag)
@@ -175,7 +306,7 @@ int fork1(char *name, int (*startFunc)(char *), char *arg,
 
 		if (name == NULL || startFunc == NULL) {
 			fprintf(stderr, "fork1(): Name and/or start function cannot be null.\n");
-			enableInterrupts();
+			irqRestore(psr);
 			return -1;
 		}
 
@@ -190,7 +321,14 @@ int fork1(char *name, int (*startFunc)(char *), char *arg,
 		if (priority > SENTINELPRIORITY || priority < MAXPRIORITY) {
 			if (DEBUG && debugflag)
 				fprintf(stderr, "fork1(): Priority out of range.\n");
-			enableInterrupts();
+			irqRestore(psr);
+			return -1;
+		}
+
+		if (flags & ~FORK_DETACHED) {
+			if (DEBUG && debugflag)
+				USLOSS_Console("fork1(): Unknown flags 0x%x.\n", flags);
+			irqRestore(psr);
 			return -1;
 		}
 
@@ -198,7 +336,7 @@ int fork1(char *name, int (*startFunc)(char *), char *arg,
 		if ( stacksize < USLOSS_MIN_STACK ){
 			if (DEBUG && debugflag)
 				USLOSS_Console("fork1(): Requested Stack size too small.\n");
-			enableInterrupts();
+			irqRestore(psr);
 			return -2;
 		}
 
@@ -206,13 +344,18 @@ int fork1(char *name, int (*startFunc)(char *), char *arg,
 		if (isProcessTableFull()){
 			if (DEBUG && debugflag)
 				USLOSS_Console("fork1(): Process Table is full.\n");
-			enableInterrupts();
+			irqRestore(psr);
 			return -1;
 		}
 
 		int pid = getNextPid();
 		procSlot = (pid - 1) % MAXPROC;
 
+		// the slot may still be waiting for the reaper
+		if (ProcTable[procSlot].status == DEAD) {
+			reapDeadProcesses();
+		}
+
 		if (DEBUG && debugflag)
 			USLOSS_Console("fork1(): %s's pid is %d\n", name, pid);
 
@@ -226,15 +369,25 @@ int fork1(char *name, int (*startFunc)(char *), char *arg,
 		strcpy(ProcTable[procSlot].name, name);
 		ProcTable[procSlot].pid = pid;
 		ProcTable[procSlot].priority = priority;
+		ProcTable[procSlot].basePriority = priority;
+		ProcTable[procSlot].waitMutex = -1;
+		ProcTable[procSlot].condMutex = -1;
+		ProcTable[procSlot].heldMutexes = NULL;
+		ProcTable[procSlot].waitsFor = NULL;
+		ProcTable[procSlot].irqDepth = 0;
 		ProcTable[procSlot].startFunc = startFunc;
 		ProcTable[procSlot].stack = (char *) malloc(stacksize * sizeof(char));
 		ProcTable[procSlot].stackSize = stacksize;
-		ProcTable[procSlot].status = READY;
+		setStatus(&ProcTable[procSlot], READY);
+		trace(TRACE_FORK, pid, Current == NULL ? -1 : Current->pid);
 		ProcTable[procSlot].numJoins = 0;
 		ProcTable[procSlot].numKids = 0;
 		ProcTable[procSlot].numLiveKids = 0;
 		ProcTable[procSlot].startTime = -1;
 		ProcTable[procSlot].totalTimeUsed = 0;
+		ProcTable[procSlot].wakeTime = -1;
+		resetStats(&ProcTable[procSlot]);
+		ProcTable[procSlot].detached = (flags & FORK_DETACHED) != 0;
 
 
 
@@ -253,7 +406,7 @@ int fork1(char *name, int (*startFunc)(char *), char *arg,
 		// the initial value of the process's program counter (PC)
 
 		//must enable interrupts before running contextinit
-		enableInterrupts();
+		irqRestore(psr);
 
 
 		USLOSS_ContextInit(&(ProcTable[procSlot].state),
@@ -262,13 +415,13 @@ int fork1(char *name, int (*startFunc)(char *), char *arg,
 											 NULL,
 											 launch);
 
-		disableInterrupts();
+		psr = irqSave();
 
 		// for future phase(s)
 		p1_fork(ProcTable[procSlot].pid);
 
 		//append this new process to current's list of children
-		if (Current != NULL) {
+		if (Current != NULL && !ProcTable[procSlot].detached) {
 			if (Current->childProcPtr == NULL) {
 				Current->childProcPtr = &ProcTable[procSlot];
 			}
@@ -294,14 +447,13 @@ int fork1(char *name, int (*startFunc)(char *), char *arg,
 		if (0 != strcmp(ProcTable[procSlot].name, "sentinel")) { // do not call dispatcher when creating sentinel
 			if (DEBUG && debugflag)
 				USLOSS_Console("fork1(): calling dispatcher()\n");
-			enableInterrupts();
 			dispatcher();
 		}
 
-		enableInterrupts();
+		irqRestore(psr);
 
 		return pid;
-} /* fork1 */
+} /* fork1Flags */
 
 /* ------------------------------------------------------------------------
 	 Name - launch
@@ -318,6 +470,8 @@ void launch()
 		if (DEBUG && debugflag)
 				USLOSS_Console("launch(): started\n");
 
+		freeDeadStack();
+
 		// Enable interrupts
 		result = enableInterrupts();
 
@@ -351,23 +505,132 @@ void launch()
 	 ------------------------------------------------------------------------ */
 int join(int *status)
 {
-	if ( !isInKernelMode() ) {
-			USLOSS_Console("join(): called while in user mode, by process %d. Halting...\n", Current->pid);
-			USLOSS_Halt(1);
-		}
-	disableInterrupts();
+	return joinChild(status, -1, "join");
+
+} /* join */
+
+
+/* ------------------------------------------------------------------------
+	 Name - tryJoin
+	 Purpose - Collect a child process that has already quit without ever
+						 blocking the caller.
+	 Parameters - a pointer to an int where the termination code of the 
+								quitting process is to be stored.
+	 Returns - the process id of the quitting child joined on.
+						 -1 if the process has been zapped
+						 -2 if the process has no children
+						 -3 if no child has quit yet
+	 Side Effects - none if no child has quit, otherwise the same as join
+	 ------------------------------------------------------------------------ */
+int tryJoin(int *status)
+{
+	return joinChild(status, 0, "tryJoin");
+
+} /* tryJoin */
+
+
+/* ------------------------------------------------------------------------
+	 Name - joinTimeout
+	 Purpose - Wait at most timeout microseconds for a child process to quit.
+						 The wait is expired by clockHandler(), so it is only as
+						 precise as the clock interrupt.
+	 Parameters - a pointer to an int where the termination code of the 
+								quitting process is to be stored, and the timeout in
+								microseconds (<= 0 behaves like tryJoin).
+	 Returns - the process id of the quitting child joined on.
+						 -1 if the process was zapped in the join
+						 -2 if the process has no children
+						 -3 if no child quit before the timeout expired
+	 Side Effects - the caller may be blocked until a child quits or the
+									timeout expires.
+	 ------------------------------------------------------------------------ */
+int joinTimeout(int *status, int timeout)
+{
+	return joinChild(status, timeout <= 0 ? 0 : timeout, "joinTimeout");
+
+} /* joinTimeout */
+
+
+/* ------------------------------------------------------------------------
+	 Name - joinAll
+	 Purpose - Wait until every child process has quit, then collect up to
+						 max of them from the quit list in one pass.
+	 Parameters - arrays of at least max entries where the pids and the
+								termination codes of the collected children are stored,
+								and the size of those arrays.
+	 Returns - the number of children collected.
+						 -1 if the process was zapped in the join, before
+								collecting any children
+						 -2 if the process has no children, an array is NULL or
+								max is negative
+	 Side Effects - the caller is blocked until its last live child quits.
+									Children beyond max, or all of them when -1 is
+									returned, stay on the quit list for later joins.
+	 ------------------------------------------------------------------------ */
+int joinAll(int pids[], int statuses[], int max)
+{
+	unsigned int psr = enterKernel("joinAll");
+
+	if (pids == NULL || statuses == NULL || max < 0) {
+		irqRestore(psr);
+		return -2;
+	}
+
+	if (Current->numJoins == Current->numKids) {
+		if (DEBUG && debugflag)
+			USLOSS_Console("joinAll(): %d has no children to join\n", Current->pid);
+		irqRestore(psr);
+		return -2;
+	}
+
+	// quit() only wakes us for the last child
+	while (Current->numLiveKids > 0) {
+		if (DEBUG && debugflag)
+			USLOSS_Console("joinAll(): waiting for %d children\n", Current->numLiveKids);
+		Current->waitAllKids = 1;
+		setStatus(Current, JOINBLOCKED);
+		dispatcher();
+		Current->waitAllKids = 0;
+	}
+
+	// leave the statuses to the caller's later joins rather than drop them
+	if (isZapped()) {
+		irqRestore(psr);
+		return -1;
+	}
+
+	int count = 0;
+	while (Current->quitList != NULL && count < max) {
+		pids[count] = collectChild(&statuses[count]);
+		count++;
+	}
+
+	irqRestore(psr);
+	return count;
+
+} /* joinAll */
+
+
+/*
+ * Does the work for join(), tryJoin() and joinTimeout().  timeout is -1 to
+ * wait forever, 0 to never block, or the number of microseconds to wait.
+ * func names the caller in the user mode error.
+ */
+static int joinChild(int *status, int timeout, const char *func)
+{
+	unsigned int psr = enterKernel(func);
 
 	if (Current->childProcPtr == NULL && Current->quitList == NULL) {
 		if (DEBUG && debugflag)
 			USLOSS_Console("join(): %d has no children\n", Current->pid);
-		enableInterrupts();
+		irqRestore(psr);
 		return -2; // has no children
 	}
 
 	if (Current->numJoins == Current->numKids) {
 		if (DEBUG && debugflag)
 			USLOSS_Console("join(): already joined for each child\n");
-		enableInterrupts();
+		irqRestore(psr);
 		return -2; // already joined for each child
 	}
 
@@ -375,30 +638,108 @@ int join(int *status)
 		if (DEBUG && debugflag)
 			USLOSS_Console("Join(): Child has already quit\n");
 	}
+	else if (timeout == 0) {
+		if (DEBUG && debugflag)
+			USLOSS_Console("join(): no child of %d has quit yet\n", Current->pid);
+		irqRestore(psr);
+		return isZapped() ? -1 : -3;
+	}
 	else { 
 		if (DEBUG && debugflag)
 			USLOSS_Console("Join(): Must wait for child\n");
-		Current->status = JOINBLOCKED;
-		enableInterrupts();
+		if (timeout > 0) {
+			armTimer(Current, refreshKernelTime() + timeout);
+		}
+		setStatus(Current, JOINBLOCKED);
+		// with one child left, that child is the only way out
+		if (timeout < 0 && Current->childProcPtr->nextSiblingPtr == NULL) {
+			waitFor(Current->childProcPtr);
+		}
 		dispatcher();
-		disableInterrupts();
+		cancelTimer(Current);
+		Current->timedOut = 0;
+
+		if (Current->quitList == NULL) { // clockHandler expired the wait
+			if (DEBUG && debugflag)
+				USLOSS_Console("join(): wait of %d timed out\n", Current->pid);
+			irqRestore(psr);
+			return isZapped() ? -1 : -3;
+		}
+	}
+
+	int pid = collectChild(status);
+
+	irqRestore(psr);
+	// dispatcher(); // FIXME: needed?
+	if (isZapped()) {
+		return -1;
 	}
+	return pid;
+
+} /* joinChild */
 
+
+/*
+ * Takes the first child off Current's quit list, stores its termination
+ * code in status and queues it for the reaper.  Returns the child's pid.
+ */
+static int collectChild(int *status)
+{
 	procPtr quitChild = Current->quitList;
-	Current->quitList = Current->quitList->quitNext;
+	Current->quitList = quitChild->quitNext;
 	*status = quitChild->quitStatus;
 	Current->numJoins++;
 	int pid = quitChild->pid;
-	cleanProcess(quitChild);
+	reapLater(quitChild);
+	return pid;
 
-	enableInterrupts();
-	// dispatcher(); // FIXME: needed?
+} /* collectChild */
+
+
+/* ------------------------------------------------------------------------
+	 Name - waitEvent
+	 Purpose - Wait for whichever comes first: a child quitting, another
+						 process calling unblockProc() on the caller, or the caller
+						 being zapped.
+	 Parameters - pointers to ints where the pid and termination code of the
+								quitting child are stored for WAIT_CHILD.
+	 Returns - WAIT_CHILD if a child quit and was joined,
+						 WAIT_UNBLOCKED if unblockProc() woke the caller,
+						 WAIT_ZAPPED if the caller has been zapped.
+	 Side Effects - the caller is blocked as WAITBLOCKED until one of the
+									events happens.  A quit child is collected as by join.
+	 ------------------------------------------------------------------------ */
+int waitEvent(int *pid, int *status)
+{
+	unsigned int psr = enterKernel("waitEvent");
+
+	int event;
 	if (isZapped()) {
-		return -1;
+		event = WAIT_ZAPPED;
+	}
+	else if (Current->quitList != NULL) {
+		event = WAIT_CHILD;
+	}
+	else {
+		if (DEBUG && debugflag)
+			USLOSS_Console("waitEvent(): %d must wait\n", Current->pid);
+		Current->wakeEvent = 0;
+		setStatus(Current, WAITBLOCKED);
+		dispatcher();
+		event = Current->wakeEvent;
+		Current->wakeEvent = 0;
 	}
-	return pid;
 
-} /* join */
+	if (event == WAIT_CHILD) {
+		*pid = collectChild(status);
+	}
+
+	if (DEBUG && debugflag)
+		USLOSS_Console("waitEvent(): %d woke for event %d\n", Current->pid, event);
+	irqRestore(psr);
+	return event;
+
+} /* waitEvent */
 
 
 /* ------------------------------------------------------------------------
@@ -409,14 +750,12 @@ int join(int *status)
 	 Parameters - the code to return to the grieving parent
 	 Returns - nothing
 	 Side Effects - changes the parent of pid child completion status list.
+						 Mutexes the process still owns pass to their first waiter.
 	 ------------------------------------------------------------------------ */
 void quit(int status)
 {
-	if ( !isInKernelMode() ) {
-		USLOSS_Console("quit(): called while in user mode, by process %d. Halting...\n", Current->pid);
-		USLOSS_Halt(1);
-	}
-	disableInterrupts();
+	// never restored, the dispatcher switches away for good
+	enterKernel("quit");
 
 	procPtr temp = Current->childProcPtr;
 	while (temp != NULL) { // Report error if trying to terminate a process who still has running children
@@ -464,9 +803,14 @@ void quit(int status)
 		}
 
 
-		// Unblock blocked parent
-		if (Current->parentPtr->status == JOINBLOCKED) {
-			Current->parentPtr->status = READY;
+		// Unblock blocked parent, once all children are gone if it is in joinAll
+		if (Current->parentPtr->status == JOINBLOCKED &&
+				(!Current->parentPtr->waitAllKids || Current->parentPtr->numLiveKids == 0)) {
+			makeReady(Current->parentPtr);
+		}
+		else if (Current->parentPtr->status == WAITBLOCKED) {
+			Current->parentPtr->wakeEvent = WAIT_CHILD;
+			makeReady(Current->parentPtr);
 		}
 	}
 
@@ -475,27 +819,54 @@ void quit(int status)
 		procPtr curr = Current->childProcPtr;
 		while (curr != NULL) {
 			procPtr next = curr->nextSiblingPtr;
-			cleanProcess(curr);
+			reapLater(curr);
 			curr = next;
 		}
 	}
 
 	// Unblock all processes that have zapped me
-	if (Current->zapperList != NULL) {
-		procPtr curr = Current->zapperList;
-		while (curr != NULL) {
-			curr->status = READY;
-			curr = curr->zapperNext;
+	wakeAllWaiters(&Current->zappers);
+
+	// Complete outstanding zapAsync calls on me, and forget the ones I made
+	int mySlot = (Current->pid - 1) % MAXPROC;
+	while (Current->asyncZappers != 0) {
+		int slot = __builtin_ctzll(Current->asyncZappers);
+		Current->asyncZappers &= Current->asyncZappers - 1;
+		ProcTable[slot].zapTargets &= ~(1ULL << mySlot);
+		zapCompleted(&ProcTable[slot], Current->pid);
+	}
+	while (Current->zapTargets != 0) {
+		int slot = __builtin_ctzll(Current->zapTargets);
+		Current->zapTargets &= Current->zapTargets - 1;
+		ProcTable[slot].asyncZappers &= ~(1ULL << mySlot);
+	}
+
+	// Wake zapTree callers once the last process of their tree is gone
+	while (Current->treeZappers != 0) {
+		procPtr zapper = &ProcTable[__builtin_ctzll(Current->treeZappers)];
+		Current->treeZappers &= Current->treeZappers - 1;
+		zapper->treeZapsLeft--;
+		if (zapper->treeZapsLeft == 0 && zapper->status == ZAPBLOCKED) {
+			makeReady(zapper);
 		}
 	}
 
-	Current->status = QUIT;
+	// Hand any mutexes still held to their waiters, or they would wait forever
+	while (Current->heldMutexes != NULL) {
+		unlockMutex(Current->heldMutexes - MutexTable);
+	}
+
+	setStatus(Current, QUIT);
 	Current->quitStatus = status;
 
 	p1_quit(Current->pid);
-	Current = NULL;
+	trace(TRACE_QUIT, Current->pid, status);
 
-	enableInterrupts();
+	// Nobody will join a detached process, so release its slot right away
+	if (Current->detached) {
+		reapLater(Current);
+	}
+	Current = NULL;
 
 	dispatcher();
 } /* quit */
@@ -514,10 +885,7 @@ void quit(int status)
 void dispatcher(void)
 {
 	// test if in kernel mode; halt if in user mode 
-	if ( !isInKernelMode() ) {
-		USLOSS_Console("dispatcher(): called while in user mode, by process %d. Halting...\n", Current->pid);
-		USLOSS_Halt(1);
-	}
+	requireKernelMode("dispatcher");
 	disableInterrupts();
 
 	//check that sentinel exists
@@ -571,23 +939,148 @@ void dispatcher(void)
 	USLOSS_Context * oldContext = Current == NULL ? NULL : &Current->state;
 	USLOSS_Context * newContext = &nextProcess->state;
 
+	// the clock interrupt already read the time if it got us here
+	long long now = timeFromTick ? kernelTime : refreshKernelTime();
+	timeFromTick = 0;
+	idleUntil = -1;
+
 	if (Current != NULL){
-		Current->totalTimeUsed = Current->totalTimeUsed + (readtime() - Current->startTime);
+		Current->totalTimeUsed = Current->totalTimeUsed + (now - Current->startTime);
 		Current->startTime = -1; //FIXME: maybe
+		if (Current != nextProcess) {
+			// still RUNNING means it was preempted and is now just waiting
+			if (Current->status == RUNNING) {
+				Current->involuntarySwitches++;
+				setStatus(Current, READY);
+			}
+			else {
+				Current->voluntarySwitches++;
+			}
+			Current->stateSince = now;
+		}
+	}
+
+	if (nextProcess != Current) {
+		nextProcess->readyTime += now - nextProcess->stateSince;
+		nextProcess->dispatches++;
+		trace(TRACE_SWITCH, nextProcess->pid, Current == NULL ? -1 : Current->pid);
+	}
+
+	// each process keeps its own critical section nesting
+	if (Current != NULL) {
+		Current->irqDepth = irqDepth;
 	}
+	irqDepth = nextProcess->irqDepth;
 
 	//reset current
 	Current = nextProcess;
-	Current->status = RUNNING;
-	Current->startTime = readtime();
+	setStatus(Current, RUNNING);
+	Current->startTime = now;
 
 	enableInterrupts();
 
 	//call to context switch
 	USLOSS_ContextSwitch(oldContext, newContext);
 
+	freeDeadStack();
+
 } /* dispatcher */
 
+/*
+	Returns the counter that time blocked in proc's current status is
+	charged to
+*/
+static long long *blockedTimeFor(procPtr proc) {
+	if (proc->status == JOINBLOCKED) {
+		return &proc->joinBlockedTime;
+	}
+	if (proc->status == ZAPBLOCKED) {
+		return &proc->zapBlockedTime;
+	}
+	if (proc->status == SLEEPBLOCKED || proc->status > MEBLOCKED) {
+		return &proc->meBlockedTime;
+	}
+	return &proc->syncBlockedTime;
+}
+
+/*
+	Changes a process's status, keeping StatusCounts up to date
+*/
+void setStatus(procPtr proc, int status) {
+	StatusCounts[proc->status > MEBLOCKED ? MEBLOCKED : proc->status]--;
+	StatusCounts[status > MEBLOCKED ? MEBLOCKED : status]++;
+	proc->status = status;
+	if (status >= JOINBLOCKED && status != QUIT && status != DEAD) {
+		trace(TRACE_BLOCK, proc->pid, status);
+	}
+}
+
+/*
+	Marks a blocked process READY, charging the time it spent blocked to
+	the reason it was blocked for
+*/
+void makeReady(procPtr proc) {
+	if (proc->status != READY && proc->status != RUNNING) {
+		trace(TRACE_WAKE, proc->pid, proc->status);
+		*blockedTimeFor(proc) += kernelTime - proc->stateSince;
+		proc->stateSince = kernelTime;
+	}
+	setStatus(proc, READY);
+	proc->waitsFor = NULL;
+	// the sentinel may have work again, and someone should run soon
+	idleUntil = -1;
+}
+
+/*
+	Returns whether target's chain of waits leads back to Current.  Every
+	blocked process waits on at most one other, so this costs only the
+	length of the chain.
+*/
+static int waitsOnCurrent(procPtr target) {
+	procPtr proc = target;
+	int steps = 0;
+	while (proc != NULL && proc != Current && steps < MAXPROC) {
+		proc = proc->waitsFor;
+		steps++;
+	}
+	return proc == Current;
+}
+
+/*
+	Records that the blocking Current can only be woken by target.  Any
+	new cycle must pass through Current, so it is found and reported here.
+*/
+void waitFor(procPtr target) {
+	Current->waitsFor = target;
+	if (!waitsOnCurrent(target)) {
+		return;
+	}
+
+	USLOSS_Console("waitFor(): deadlock: %s (pid %d)", Current->name, Current->pid);
+	procPtr proc = Current;
+	do {
+		USLOSS_Console(" %s %s (pid %d)", proc->status == ZAPBLOCKED ? "zaps" : "joins",
+				proc->waitsFor->name, proc->waitsFor->pid);
+		proc = proc->waitsFor;
+	} while (proc != Current);
+	USLOSS_Console("\n");
+}
+
+/*
+	Clears a process's scheduling statistics
+*/
+static void resetStats(procPtr proc) {
+	proc->stateSince = kernelTime;
+	proc->readyTime = 0;
+	proc->joinBlockedTime = 0;
+	proc->zapBlockedTime = 0;
+	proc->meBlockedTime = 0;
+	proc->syncBlockedTime = 0;
+	proc->dispatches = 0;
+	proc->voluntarySwitches = 0;
+	proc->involuntarySwitches = 0;
+}
+
 
 /* ------------------------------------------------------------------------
 	 Name - sentinel
@@ -607,14 +1100,18 @@ int sentinel (char *dummy)
 	if (DEBUG && debugflag)
 			USLOSS_Console("sentinel(): called\n");
 
-	if ( !isInKernelMode() ) {
-		USLOSS_Console("sentinel(): called while in user mode, by process %d. Halting...\n", Current->pid);
-		USLOSS_Halt(1);
-	}
+	requireKernelMode("sentinel");
 
 	while (1)
 	{
-		checkDeadlock();
+		// nothing can change while idle until a tick has work or a
+		// process is made ready, so skip the checks until then
+		if (idleUntil == -1) {
+			reapDeadProcesses();
+			checkDeadlock();
+			idleClock = refreshKernelTime();
+			idleUntil = nextTimerDeadline();
+		}
 		USLOSS_WaitInt();
 	}
 } /* sentinel */
@@ -623,23 +1120,26 @@ int sentinel (char *dummy)
 /* check to determine if deadlock has occurred... */
 static void checkDeadlock()
 {
-	int i;
-	int blocked = 1;
-	for( i = 0; i < MINPRIORITY; i++){ //loop through each priority
-		procPtr temp = ReadyLists[i];
-		if (temp != NULL) {
-			procPtr proc = ReadyLists[i];
-			while (proc != NULL) {
+	// a timed wait will be expired by the clock, so nothing is stuck yet
+	if (numTimers > 0) {
+		return;
+	}
+
+	// the sentinel itself is the one runnable process expected
+	if (StatusCounts[READY] + StatusCounts[RUNNING] > 1) {
+		for (int i = 0; i < MINPRIORITY; i++) {
+			for (procPtr proc = ReadyLists[i]; proc != NULL; proc = proc->nextProcPtr) {
 				if (proc->status == READY || proc->status == RUNNING) {
 					fprintf(stderr, "checkDeadlock(): found another process (name: %s, pid: %d, status: %d) on the ready list.\n", proc->name, proc->pid, proc->status);
 					USLOSS_Halt(1);
 				}
-				blocked = blocked && (proc->status == JOINBLOCKED || proc->status == ZAPBLOCKED || proc->status > MEBLOCKED); //FIXME: maybe not 100% sure about this
-				proc = proc->nextProcPtr;
 			}
 		}
 	}
 
+	// everyone else is blocked, unless some have quit and wait to be joined
+	int blocked = StatusCounts[QUIT] == 0 && StatusCounts[DEAD] == 0;
+
 	if (blocked) {
 		USLOSS_Console("checkDeadlock(): numProc = %d. Only Sentinel should be left. Halting...\n", countProcesses());
 	}
@@ -659,10 +1159,13 @@ void disableInterrupts()
 		// turn the interrupts OFF iff we are in kernel mode
 		// if not in kernel mode, print an error message and
 		// halt USLOSS
-	if (isInKernelMode()) {
-		unsigned int psr = USLOSS_PsrGet();
-		unsigned int op = 0xfffffffd;
-		int result = USLOSS_PsrSet(psr & op);
+	unsigned int psr = psrGet();
+	if (psr & USLOSS_PSR_CURRENT_MODE) {
+		// already off, e.g. in an interrupt handler or irqSave() section
+		if ((psr & USLOSS_PSR_CURRENT_INT) == 0) {
+			return;
+		}
+		int result = psrSet(psr & ~USLOSS_PSR_CURRENT_INT);
 		if (result == USLOSS_ERR_INVALID_PSR) {
 			fprintf(stderr, "Failed to set PSR to kernel mode.");
 			USLOSS_Halt(0);
@@ -673,23 +1176,21 @@ void disableInterrupts()
 		USLOSS_Halt(0);
 	}
 
-	// TODO: May need more than just switching the bit?
-
 } /* disableInterrupts */
 
 /*
  * Returns 1 if in kernel mode, else 0.
  */
 int isInKernelMode() {
-	unsigned int psr = USLOSS_PsrGet();
+	unsigned int psr = psrGet();
 	unsigned int op = 0x1;
 	return psr & op;
 }
 
 int enterKernelMode() {
-	unsigned int psr = USLOSS_PsrGet();
+	unsigned int psr = psrGet();
 	unsigned int op = 0x1;
-	int result = USLOSS_PsrSet(psr | op);
+	int result = psrSet(psr | op);
 	if (result == USLOSS_ERR_INVALID_PSR) {
 		return -1;
 	}
@@ -701,9 +1202,9 @@ int enterKernelMode() {
 }
 
 int enterUserMode() {
-	unsigned int psr = USLOSS_PsrGet();
+	unsigned int psr = psrGet();
 	unsigned int op = 0xfffffffe;
-	int result = USLOSS_PsrSet(psr & op);
+	int result = psrSet(psr & op);
 	if (result == USLOSS_ERR_INVALID_PSR) {
 		return -1;
 	}
@@ -717,68 +1218,348 @@ int enterUserMode() {
  * Returns 1 if interrupts are enabled, else 0.
  */
 int isInterruptEnabled() {
-	unsigned int psr = USLOSS_PsrGet();
+	unsigned int psr = psrGet();
 	unsigned int op = 0x2;
 	return (psr & op) >> 1;
 }
 
 int enableInterrupts() {
-	unsigned int psr = USLOSS_PsrGet();
-	unsigned int op = 0x2;
-	int result = USLOSS_PsrSet(psr | op);
+	// an enclosing irqSave() section turns them back on when it ends
+	if (irqDepth > 0) {
+		return 0;
+	}
+	unsigned int psr = psrGet();
+	if (psr & USLOSS_PSR_CURRENT_INT) {
+		return 0;
+	}
+	int result = psrSet(psr | USLOSS_PSR_CURRENT_INT);
 	if (result == USLOSS_ERR_INVALID_PSR) {
 		return -1;
 	}
 	else {
 		return 0;
 	}
+}
 
-	// TODO: May need more than just switching the bit?
+/*
+ * Disables interrupts for a critical section that may be nested in
+ * others, and returns the PSR to hand back to irqRestore() at its end.
+ * Kernel functions called inside the section leave interrupts off.  In
+ * user mode nothing is changed; callers check the mode in the PSR.
+ */
+unsigned int irqSave() {
+	unsigned int psr = psrGet();
+	if ((psr & USLOSS_PSR_CURRENT_MODE) == 0) {
+		return psr;
+	}
+	if (psr & USLOSS_PSR_CURRENT_INT) {
+		psrSet(psr & ~USLOSS_PSR_CURRENT_INT);
+	}
+	irqDepth++;
+	return psr;
 }
 
 /*
-	Checks if process table is full
-*/
+ * Ends an irqSave() section, restoring the PSR saved at its start.
+ * Interrupts stay off for the whole section, so the PSR only has to be
+ * written when they were on before it.
+ */
+void irqRestore(unsigned int psr) {
+	// irqSave() left user mode alone, so there is nothing to undo
+	if ((psr & USLOSS_PSR_CURRENT_MODE) == 0) {
+		return;
+	}
+	irqDepth--;
+	if (psr & USLOSS_PSR_CURRENT_INT) {
+		psrSet(psr);
+	}
+}
 
-int isProcessTableFull(){
-	for (int i = 0; i < MAXPROC; i++){
-		if (ProcTable[i].status == EMPTY){
-			return 0;
-		}
+/*
+ * Starts the irqSave() section of a kernel entry point, halting if func
+ * was called in user mode.  The mode is checked in the PSR irqSave() has
+ * already read, so the check costs nothing extra.
+ */
+static unsigned int enterKernel(const char *func) {
+	unsigned int psr = irqSave();
+	if ((psr & USLOSS_PSR_CURRENT_MODE) == 0) {
+		USLOSS_Console("%s(): called while in user mode, by process %d. Halting...\n", func, Current->pid);
+		USLOSS_Halt(1);
 	}
-	return 1;
+	return psr;
 }
 
 /*
-	Scans for available pid
-*/
-unsigned int getNextPid(){
-	// USLOSS_Console("---next pid = %d before loop--\n", nextPid);
-	do {
-		nextPid++;
-	} while (ProcTable[(nextPid - 1) % MAXPROC].status != EMPTY);
-	// USLOSS_Console("---next pid = %d after loop--\n", nextPid);
+ * Counted wrappers for the PSR, see getPsrOps().
+ */
+static unsigned int psrGet() {
+	psrReads++;
+	return USLOSS_PsrGet();
+}
 
-	return nextPid;
+static int psrSet(unsigned int psr) {
+	psrWrites++;
+	return USLOSS_PsrSet(psr);
 }
 
-void initProcessTable(){
-	for (int i = 0; i < MAXPROC; i++){
-		ProcTable[i].status = EMPTY;
-	}
+/* ------------------------------------------------------------------------
+	 Name - getPsrOps
+	 Purpose - Reports how many times the kernel has read and written the
+						 PSR, for measuring the cost of kernel calls.
+	 Parameters - where to store the number of reads and of writes
+	 Returns - nothing
+	 Side Effects - none
+	 ----------------------------------------------------------------------- */
+void getPsrOps(int *reads, int *writes) {
+	*reads = psrReads;
+	*writes = psrWrites;
 }
 
-void initReadyLists(){
-	// TODO: do something maybe
+/*
+	Records an event in the trace ring, overwriting the oldest once full
+*/
+static void trace(int event, int pid, int arg) {
+	traceRecord *rec = &TraceRing[traceCount++ % TRACESIZE];
+	rec->time = kernelTime;
+	rec->arg = arg;
+	rec->pid = pid;
+	rec->event = event;
 }
 
-void addProcToReadyLists(int procSlot, int priority){
+/* ------------------------------------------------------------------------
+	 Name - readTrace
+	 Purpose - Copies the most recent events out of the trace ring.
+	 Parameters - where to copy them, and room for how many
+	 Returns - the number of records copied, oldest first
+	 Side Effects - none
+	 ----------------------------------------------------------------------- */
+int readTrace(traceRecord records[], int max) {
+	unsigned int psr = enterKernel("readTrace");
 
-	int rl_index = priority - 1;
+	int count = traceCount < TRACESIZE ? traceCount : TRACESIZE;
+	if (max < count) {
+		count = max < 0 ? 0 : max;
+	}
+	unsigned int first = traceCount - count;
+	for (int i = 0; i < count; i++) {
+		records[i] = TraceRing[(first + i) % TRACESIZE];
+	}
 
-	if (ReadyLists[rl_index] == NULL){
-		ReadyLists[rl_index] = &ProcTable[procSlot];
-	} else {
+	irqRestore(psr);
+	return count;
+}
+
+/* ------------------------------------------------------------------------
+	 Name - snapshotProcesses
+	 Purpose - Copies every process in the table, from READY through QUIT,
+						 into a compact form for monitoring.
+	 Parameters - where to copy them, and room for how many
+	 Returns - the number of processes copied, in slot order
+						 -2 if procs is NULL or max is negative
+	 Side Effects - none
+	 ----------------------------------------------------------------------- */
+int snapshotProcesses(procSnapshot procs[], int max) {
+	unsigned int psr = enterKernel("snapshotProcesses");
+
+	if (procs == NULL || max < 0) {
+		irqRestore(psr);
+		return -2;
+	}
+
+	int n = 0;
+	for (int i = 0; i < MAXPROC && n < max; i++) {
+		procPtr proc = &ProcTable[i];
+		if (proc->status == EMPTY || proc->status == DEAD) {
+			continue;
+		}
+		procSnapshot *snap = &procs[n++];
+		snap->pid = proc->pid;
+		snap->parentPid = proc->parentPtr == NULL ? -1 : proc->parentPtr->pid;
+		snap->priority = proc->priority;
+		snap->status = proc->status;
+		snap->numLiveKids = proc->numLiveKids;
+		snap->numJoins = proc->numJoins;
+		snap->zapped = proc->zapped;
+		snap->cpuTime = proc->totalTimeUsed;
+		if (proc == Current) {
+			snap->cpuTime += kernelTime - proc->startTime;
+		}
+		strcpy(snap->name, proc->name);
+	}
+
+	irqRestore(psr);
+	return n;
+}
+
+/* ------------------------------------------------------------------------
+	 Name - snapshotToCSV
+	 Purpose - Formats a snapshot as CSV, a header line and then one line
+						 per process.  Statuses 0 to MEBLOCKED - 1 are named, others
+						 printed as numbers.
+	 Parameters - the snapshot and its length, and the buffer to write into
+								and its size
+	 Returns - the length of the text written
+						 -2 if an argument is invalid or the text does not fit
+	 Side Effects - none
+	 ----------------------------------------------------------------------- */
+int snapshotToCSV(procSnapshot procs[], int n, char *buf, int size) {
+	if (procs == NULL || n < 0 || buf == NULL || size <= 0) {
+		return -2;
+	}
+	int len = 0;
+	int fits = appendf(buf, size, &len, "pid,parentPid,name,priority,status,numLiveKids,numJoins,zapped,cpuTime\n");
+	for (int i = 0; i < n && fits; i++) {
+		procSnapshot *snap = &procs[i];
+		fits = appendf(buf, size, &len, "%d,%d,", snap->pid, snap->parentPid) &&
+				appendName(buf, size, &len, snap->name, 0) &&
+				(snap->status >= 0 && snap->status < MEBLOCKED ?
+					appendf(buf, size, &len, ",%d,%s,", snap->priority, StatusNames[snap->status]) :
+					appendf(buf, size, &len, ",%d,%d,", snap->priority, snap->status)) &&
+				appendf(buf, size, &len, "%d,%d,%d,%lld\n", snap->numLiveKids, snap->numJoins, snap->zapped, snap->cpuTime);
+	}
+	return fits ? len : -2;
+}
+
+/* ------------------------------------------------------------------------
+	 Name - snapshotToJSON
+	 Purpose - Formats a snapshot as a JSON array with one object per
+						 process.  Statuses 0 to MEBLOCKED - 1 are named, others printed
+						 as numbers.
+	 Parameters - the snapshot and its length, and the buffer to write into
+								and its size
+	 Returns - the length of the text written
+						 -2 if an argument is invalid or the text does not fit
+	 Side Effects - none
+	 ----------------------------------------------------------------------- */
+int snapshotToJSON(procSnapshot procs[], int n, char *buf, int size) {
+	if (procs == NULL || n < 0 || buf == NULL || size <= 0) {
+		return -2;
+	}
+	int len = 0;
+	int fits = appendf(buf, size, &len, "[");
+	for (int i = 0; i < n && fits; i++) {
+		procSnapshot *snap = &procs[i];
+		fits = appendf(buf, size, &len, "%s{\"pid\":%d,\"parentPid\":%d,\"name\":",
+					i == 0 ? "" : ",", snap->pid, snap->parentPid) &&
+				appendName(buf, size, &len, snap->name, 1) &&
+				(snap->status >= 0 && snap->status < MEBLOCKED ?
+					appendf(buf, size, &len, ",\"priority\":%d,\"status\":\"%s\",", snap->priority, StatusNames[snap->status]) :
+					appendf(buf, size, &len, ",\"priority\":%d,\"status\":%d,", snap->priority, snap->status)) &&
+				appendf(buf, size, &len, "\"numLiveKids\":%d,\"numJoins\":%d,\"zapped\":%s,\"cpuTime\":%lld}",
+					snap->numLiveKids, snap->numJoins, snap->zapped ? "true" : "false", snap->cpuTime);
+	}
+	fits = fits && appendf(buf, size, &len, "]\n");
+	return fits ? len : -2;
+}
+
+/*
+	Appends formatted text at buf + *len.  Returns 0, leaving the text
+	truncated, if it does not fit in size.
+*/
+static int appendf(char *buf, int size, int *len, char *format, ...) {
+	va_list args;
+	va_start(args, format);
+	int n = vsnprintf(buf + *len, size - *len, format, args);
+	va_end(args);
+	if (n < 0 || n >= size - *len) {
+		return 0;
+	}
+	*len += n;
+	return 1;
+}
+
+/*
+	Appends a process name as a quoted CSV field or JSON string
+*/
+static int appendName(char *buf, int size, int *len, char *name, int json) {
+	int fits = appendf(buf, size, len, "\"");
+	for (char *c = name; *c != '\0' && fits; c++) {
+		if (*c == '"') {
+			fits = appendf(buf, size, len, json ? "\\\"" : "\"\"");
+		}
+		else if (json && (*c == '\\' || (unsigned char) *c < 0x20)) {
+			fits = appendf(buf, size, len, "\\u%04x", (unsigned char) *c);
+		}
+		else {
+			fits = appendf(buf, size, len, "%c", *c);
+		}
+	}
+	return fits && appendf(buf, size, len, "\"");
+}
+
+/* ------------------------------------------------------------------------
+	 Name - dumpTrace
+	 Purpose - Decodes and prints the whole trace ring, oldest event first.
+	 Parameters - none
+	 Returns - nothing
+	 Side Effects - none
+	 ----------------------------------------------------------------------- */
+void dumpTrace(void) {
+	char *events[TRACE_TIMEOUT + 1];
+	events[0] = "?";
+	events[TRACE_FORK] = "FORK";
+	events[TRACE_QUIT] = "QUIT";
+	events[TRACE_SWITCH] = "SWITCH";
+	events[TRACE_BLOCK] = "BLOCK";
+	events[TRACE_WAKE] = "WAKE";
+	events[TRACE_ZAP] = "ZAP";
+	events[TRACE_TIMEOUT] = "TIMEOUT";
+
+	int count = traceCount < TRACESIZE ? traceCount : TRACESIZE;
+	USLOSS_Console("TRACE: last %d of %u events\n", count, traceCount);
+	USLOSS_Console("        TIME   EVENT   PID         ARG\n");
+	for (unsigned int i = traceCount - count; i != traceCount; i++) {
+		traceRecord *rec = &TraceRing[i % TRACESIZE];
+		USLOSS_Console("%12lld %7s %5d %11d\n", rec->time, events[rec->event], rec->pid, rec->arg);
+	}
+}
+
+/*
+	Checks if process table is full
+*/
+
+int isProcessTableFull(){
+	for (int i = 0; i < MAXPROC; i++){
+		if (ProcTable[i].status == EMPTY || ProcTable[i].status == DEAD){
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/*
+	Scans for available pid
+*/
+unsigned int getNextPid(){
+	// USLOSS_Console("---next pid = %d before loop--\n", nextPid);
+	do {
+		nextPid++;
+	} while (ProcTable[(nextPid - 1) % MAXPROC].status != EMPTY &&
+					 ProcTable[(nextPid - 1) % MAXPROC].status != DEAD);
+	// USLOSS_Console("---next pid = %d after loop--\n", nextPid);
+
+	return nextPid;
+}
+
+void initProcessTable(){
+	for (int i = 0; i < MAXPROC; i++){
+		ProcTable[i].status = EMPTY;
+		ProcTable[i].wakeTime = -1;
+	}
+	StatusCounts[EMPTY] = MAXPROC;
+}
+
+void initReadyLists(){
+	// TODO: do something maybe
+}
+
+void addProcToReadyLists(int procSlot, int priority){
+
+	int rl_index = priority - 1;
+
+	if (ReadyLists[rl_index] == NULL){
+		ReadyLists[rl_index] = &ProcTable[procSlot];
+	} else {
 		procPtr prev = NULL;
 		procPtr curr = ReadyLists[rl_index];
 		while (curr != NULL){
@@ -791,10 +1572,10 @@ void addProcToReadyLists(int procSlot, int priority){
 		USLOSS_Console("fork1(): adding %s to readylist at priority %d\n", ReadyLists[rl_index]->name, priority);
 }
 
-void cleanProcess(procPtr proc) {	
-	if (DEBUG && debugflag)
-		USLOSS_Console("cleanProcess(): removing %d from ReadyList\n", proc->pid);
-	//remove proc from ready list
+/*
+	Unlinks a process from the ready list of its priority
+*/
+void removeProcFromReadyLists(procPtr proc) {
 	if (ReadyLists[proc->priority -1] != NULL){
 
 		if (ReadyLists[proc->priority -1]->pid == proc->pid){
@@ -808,47 +1589,242 @@ void cleanProcess(procPtr proc) {
 				fore = fore->nextProcPtr;
 			}
 
-			aft->nextProcPtr = proc->nextProcPtr;
+			if (fore != NULL) {
+				aft->nextProcPtr = proc->nextProcPtr;
+			}
 		}
 	}
 	proc->nextProcPtr = NULL;
+}
+
+/*
+	Moves a process to the ready list of a new priority
+*/
+void setPriority(procPtr proc, int priority) {
+	if (proc->priority == priority) {
+		return;
+	}
+	if (DEBUG && debugflag)
+		USLOSS_Console("setPriority(): %d from %d to %d\n", proc->pid, proc->priority, priority);
+	removeProcFromReadyLists(proc);
+	proc->priority = priority;
+	addProcToReadyLists((proc->pid - 1) % MAXPROC, priority);
+}
+
+void cleanProcess(procPtr proc) {	
+	if (DEBUG && debugflag)
+		USLOSS_Console("cleanProcess(): removing %d from ReadyList\n", proc->pid);
+	removeProcFromReadyLists(proc);
+
+	// a process cannot free the stack it is still running on
+	if (proc == Current) {
+		deadStack = proc->stack;
+	}
+	else {
+		free(proc->stack);
+	}
+	proc->stack = NULL;
+
+	proc->nextProcPtr = NULL;
 	proc->childProcPtr = NULL;
 	proc->nextSiblingPtr = NULL;
 	proc->quitList = NULL;
 	proc->quitNext = NULL;
 	proc->parentPtr = NULL;
 	proc->quitStatus = 0;
-	proc->status = EMPTY;
+	setStatus(proc, EMPTY);
 	proc->zapped = 0;
-	proc->zapperList = NULL;
-	proc->zapperNext = NULL;
+	initWaitQueue(&proc->zappers);
+	proc->waitNext = NULL;
+	proc->waitsFor = NULL;
 	proc->startTime = -1;
 	proc->totalTimeUsed = 0;
+	resetStats(proc);
+	cancelTimer(proc);
+	proc->timedOut = 0;
+	proc->asyncZappers = 0;
+	proc->zapTargets = 0;
+	proc->numZapDone = 0;
+	proc->zapWaitMode = 0;
+	proc->treeZappers = 0;
+	proc->treeZapsLeft = 0;
+	proc->detached = 0;
+	proc->waitAllKids = 0;
+	proc->reapNext = NULL;
+}
+
+/*
+	Empties a wait queue
+*/
+void initWaitQueue(waitQueue *queue) {
+	queue->head = NULL;
+	queue->tail = NULL;
+	queue->count = 0;
+}
+
+/*
+	Appends a process to the tail of a wait queue in O(1)
+*/
+void enqueueWaiter(waitQueue *queue, procPtr proc) {
+	proc->waitNext = NULL;
+	if (queue->tail == NULL) {
+		queue->head = proc;
+	}
+	else {
+		queue->tail->waitNext = proc;
+	}
+	queue->tail = proc;
+	queue->count++;
+}
+
+/*
+	Removes and returns the process at the head of a wait queue, or NULL
+*/
+procPtr dequeueWaiter(waitQueue *queue) {
+	procPtr proc = queue->head;
+	if (proc != NULL) {
+		queue->head = proc->waitNext;
+		if (queue->head == NULL) {
+			queue->tail = NULL;
+		}
+		proc->waitNext = NULL;
+		queue->count--;
+	}
+	return proc;
+}
+
+/*
+	Unlinks proc from a wait queue given the process before it (NULL if
+	proc is the head)
+*/
+void removeWaiter(waitQueue *queue, procPtr prev, procPtr proc) {
+	if (prev == NULL) {
+		queue->head = proc->waitNext;
+	}
+	else {
+		prev->waitNext = proc->waitNext;
+	}
+	if (queue->tail == proc) {
+		queue->tail = prev;
+	}
+	proc->waitNext = NULL;
+	queue->count--;
+}
+
+/*
+	Makes every process on a wait queue READY in one pass and empties the
+	queue.  Processes never leave their ready list in this kernel, so
+	waking one only flips its status.  Returns the best (numerically
+	lowest) priority woken, or SENTINELPRIORITY + 1 if the queue was empty.
+*/
+int wakeAllWaiters(waitQueue *queue) {
+	int best = SENTINELPRIORITY + 1;
+	procPtr proc = queue->head;
+	while (proc != NULL) {
+		procPtr next = proc->waitNext;
+		makeReady(proc);
+		proc->waitNext = NULL;
+		if (proc->priority < best) {
+			best = proc->priority;
+		}
+		proc = next;
+	}
+	initWaitQueue(queue);
+	return best;
+}
+
+/*
+	Marks a joined or detached process dead and queues its slot for the
+	reaper, so the caller only pays for the bookkeeping it needs now.
+	The queue is cleaned once it reaches REAPTHRESHOLD, when the sentinel
+	runs, or when fork1 needs one of the slots.
+*/
+void reapLater(procPtr proc) {
+	setStatus(proc, DEAD);
+	proc->parentPtr = NULL;
+	proc->reapNext = NULL;
+	if (ReapTail == NULL) {
+		ReapList = proc;
+	}
+	else {
+		ReapTail->reapNext = proc;
+	}
+	ReapTail = proc;
+	numDead++;
+
+	if (numDead >= REAPTHRESHOLD) {
+		reapDeadProcesses();
+	}
+}
+
+/*
+	Cleans every slot queued by reapLater
+*/
+void reapDeadProcesses() {
+	if (DEBUG && debugflag && numDead > 0)
+		USLOSS_Console("reapDeadProcesses(): cleaning %d slots\n", numDead);
+	while (ReapList != NULL) {
+		procPtr proc = ReapList;
+		ReapList = proc->reapNext;
+		cleanProcess(proc);
+	}
+	ReapTail = NULL;
+	numDead = 0;
+}
+
+/*
+	Frees the stack of a process that cleaned itself up on its way out.
+	Called once we are running on some other stack.
+*/
+void freeDeadStack() {
+	if (deadStack != NULL) {
+		free(deadStack);
+		deadStack = NULL;
+	}
 }
 
 // its PID, parent’s PID, priority, process status (e.g. empty, running, ready, blocked, etc.), number of children, CPU time consumed, and na
 void dumpProcesses() {
-	char * statuses[6];
-	statuses[EMPTY] = "EMPTY";
-	statuses[READY] = "READY";
-	statuses[RUNNING] = "RUNNING";
-	statuses[JOINBLOCKED] = "JOINBLOCKED";
-	statuses[ZAPBLOCKED] = "ZAPBLOCKED";
-	statuses[QUIT] = "QUIT";
+	char **statuses = StatusNames;
 
 	USLOSS_Console(" SLOT   PID       NAME       PARENTPID   PRIORITY     STATUS     NUM CHILDREN  NUM LIVE KIDS  NUM JOINS   TIME USED \n");
 	USLOSS_Console("------ ----- -------------- ----------- ---------- ------------ -------------- ------------- ----------- -----------\n");
 	for (int i = 0; i < MAXPROC; i++){
 			procPtr temp = &ProcTable[i];
 			int parentpid = temp->parentPtr == NULL? -1 : temp->parentPtr->pid;
-			if (temp->status > MEBLOCKED)
-				USLOSS_Console("%6d %5d %14s %11d %10d %12d %14d %13d %11d %11d\n", i, temp->pid, temp->name, parentpid, temp->priority, temp->status, temp->numKids, temp->numLiveKids, temp->numJoins, temp->totalTimeUsed);
+			// slots waiting for the reaper are as good as empty
+			int status = temp->status == DEAD ? EMPTY : temp->status;
+			if (status > MEBLOCKED)
+				USLOSS_Console("%6d %5d %14s %11d %10d %12d %14d %13d %11d %11lld\n", i, temp->pid, temp->name, parentpid, temp->priority, status, temp->numKids, temp->numLiveKids, temp->numJoins, temp->totalTimeUsed);
 			else 
-				USLOSS_Console("%6d %5d %14s %11d %10d %12s %14d %13d %11d %11d\n", i, temp->pid, temp->name, parentpid, temp->priority, statuses[temp->status], temp->numKids, temp->numLiveKids, temp->numJoins, temp->totalTimeUsed);
+				USLOSS_Console("%6d %5d %14s %11d %10d %12s %14d %13d %11d %11lld\n", i, temp->pid, temp->name, parentpid, temp->priority, statuses[status], temp->numKids, temp->numLiveKids, temp->numJoins, temp->totalTimeUsed);
 	}
+	dumpStatusCounts();
+}
+
+/*
+	Prints how many processes are in each status, the last line of
+	dumpProcesses()
+*/
+void dumpStatusCounts() {
+	USLOSS_Console("READY %d, RUNNING %d, JOINBLOCKED %d, ZAPBLOCKED %d, MEBLOCKED %d, OTHER BLOCKED %d, QUIT %d, DEAD %d\n",
+			StatusCounts[READY], StatusCounts[RUNNING], StatusCounts[JOINBLOCKED], StatusCounts[ZAPBLOCKED], StatusCounts[MEBLOCKED],
+			StatusCounts[WAITBLOCKED] + StatusCounts[SYNCBLOCKED] + StatusCounts[SLEEPBLOCKED], StatusCounts[QUIT], StatusCounts[DEAD]);
 }
 
+/* ------------------------------------------------------------------------
+	 Name - zap
+	 Purpose - Marks a process as zapped and waits for it to quit.
+	 Parameters - pid of the process to zap
+	 Returns - -1 if the calling process itself was zapped while waiting,
+						 -3 if the process is already waiting on the caller, directly
+								or through others, so waiting for it would deadlock,
+						 0 once it has quit
+	 Side Effects - the process is marked as zapped, unless -3 is returned
+	 ----------------------------------------------------------------------- */
 int zap(int pid) {
+	unsigned int psr = enterKernel("zap");
+
 	if (pid == Current->pid) {
 		fprintf(stderr, "zap(): process %d tried to zap itself.  Halting...\n", Current->pid);
 		USLOSS_Halt(1);
@@ -856,12 +1832,13 @@ int zap(int pid) {
 
 	int procSlot = (pid - 1) % MAXPROC;
 
-	if (ProcTable[procSlot].status == EMPTY || ProcTable[procSlot].pid != pid) {
+	if (pid < 1 || ProcTable[procSlot].status == EMPTY || ProcTable[procSlot].status == DEAD || ProcTable[procSlot].pid != pid) {
 		fprintf(stderr, "zap(): process being zapped does not exist.  Halting...\n");
 		USLOSS_Halt(1);
 	}
 
 	if(ProcTable[procSlot].status == QUIT) {
+		irqRestore(psr);
 		if (isZapped()) {
 			return -1;
 		}
@@ -870,24 +1847,24 @@ int zap(int pid) {
 		}
 	}
 
-	ProcTable[procSlot].zapped = 1;
-	if (ProcTable[procSlot].zapperList == NULL) {
-		ProcTable[procSlot].zapperList = Current;
-	}
-	else {
-		procPtr prev = NULL;
-		procPtr curr = ProcTable[procSlot].zapperList;
-		while (curr != NULL) {
-			prev = curr;
-			curr = curr->zapperNext;
-		}
-		prev->zapperNext = Current;
+	// the target is already waiting, directly or not, on us
+	if (waitsOnCurrent(&ProcTable[procSlot])) {
+		if (DEBUG && debugflag)
+			USLOSS_Console("zap(): zapping %d would deadlock %d\n", pid, Current->pid);
+		irqRestore(psr);
+		return -3;
 	}
 
-	Current->status = ZAPBLOCKED;
+	markZapped(&ProcTable[procSlot]);
+	enqueueWaiter(&ProcTable[procSlot].zappers, Current);
+
+	setStatus(Current, ZAPBLOCKED);
+	trace(TRACE_ZAP, Current->pid, pid);
+	waitFor(&ProcTable[procSlot]);
 
 	dispatcher();
 
+	irqRestore(psr);
 	if (isZapped()) {
 		return -1;
 	}
@@ -895,109 +1872,1591 @@ int zap(int pid) {
 	return 0;
 }
 
-int isZapped(void) {
-	return Current->zapped;
+/*
+	Sets a process's zapped flag and wakes it if it is in waitEvent()
+*/
+void markZapped(procPtr proc) {
+	proc->zapped = 1;
+	if (proc->status == WAITBLOCKED) {
+		proc->wakeEvent = WAIT_ZAPPED;
+		makeReady(proc);
+	}
 }
 
-int getpid(void) {
-	return Current->pid;
-}
+/* ------------------------------------------------------------------------
+	 Name - zapAsync
+	 Purpose - Zap a process without waiting for it to quit.  The caller
+						 collects completed zaps later with zapWait().
+	 Parameters - the pid of the process to zap
+	 Returns - a handle for the zap, which is the pid of the zapped process.
+						 The handle is reported by zapWait() once that process quits.
+						 -3 if MAXPROC zaps are already outstanding or completed
+								but not collected by zapWait()
+	 Side Effects - the target is marked as zapped, unless -3 is returned
+	 ------------------------------------------------------------------------ */
+int zapAsync(int pid) {
+	unsigned int psr = enterKernel("zapAsync");
 
-int blockMe(int block_status) {
-	if ( !isInKernelMode() ) {
-		USLOSS_Console("blockMe(): called while in user mode, by process %d. Halting...\n", Current->pid);
+	if (pid == Current->pid) {
+		fprintf(stderr, "zapAsync(): process %d tried to zap itself.  Halting...\n", Current->pid);
 		USLOSS_Halt(1);
 	}
 
-	disableInterrupts();
+	int procSlot = (pid - 1) % MAXPROC;
+	procPtr target = pid < 1 ? NULL : &ProcTable[procSlot];
 
-	if (block_status <= MEBLOCKED){
-		USLOSS_Console("blockMe(): cannot block process with status (%d) <= 10. Halting...\n", block_status);
+	if (target == NULL || target->status == EMPTY || target->status == DEAD || target->pid != pid) {
+		fprintf(stderr, "zapAsync(): process being zapped does not exist.  Halting...\n");
 		USLOSS_Halt(1);
 	}
 
-	Current->status = block_status;
-	dispatcher();
-	if (isZapped()){
-		enableInterrupts();
-		return -1;
+	// every handle must fit in zapDone once its zap completes
+	if (Current->numZapDone + __builtin_popcountll(Current->zapTargets) >= MAXPROC) {
+		irqRestore(psr);
+		return -3;
 	}
-	enableInterrupts();
-	return 0;
-}
 
-int unblockProc(int pid) {
-	if ( !isInKernelMode() ) {
-		USLOSS_Console("unblockProc(): called while in user mode, by process %d. Halting...\n", Current->pid);
-		USLOSS_Halt(1);
+	if (target->status == QUIT) { // already complete
+		zapCompleted(Current, pid);
+	}
+	else {
+		int mySlot = (Current->pid - 1) % MAXPROC;
+		markZapped(target);
+		target->asyncZappers |= 1ULL << mySlot;
+		Current->zapTargets |= 1ULL << procSlot;
 	}
 
-	disableInterrupts();
+	if (DEBUG && debugflag)
+		USLOSS_Console("zapAsync(): %d zapped %d\n", Current->pid, pid);
+	irqRestore(psr);
+	return pid;
+}
 
-	//returns -2 if proc is the current process, does not exist, not me-blocked, or blocked on status <= 10
-	if (pid == Current->pid){
-		if (DEBUG && debugflag)
-			USLOSS_Console("unblockProc(): attempting to unblock Current process (pid %d).\n", pid);
-		enableInterrupts();
-		return -2;
-	}
+/* ------------------------------------------------------------------------
+	 Name - zapWait
+	 Purpose - Wait for outstanding zapAsync() calls to complete.
+	 Parameters - ZAP_WAIT_ANY to wait for one zapped process to quit, or
+								ZAP_WAIT_ALL to wait for all of them.
+	 Returns - ZAP_WAIT_ANY: the handle of a completed zap.
+						 ZAP_WAIT_ALL: the number of completed zaps collected.
+						 -1 if the caller was zapped while waiting
+						 -2 if mode is invalid or there are no zaps to wait for
+	 Side Effects - the caller may be blocked as ZAPBLOCKED
+	 ------------------------------------------------------------------------ */
+int zapWait(int mode) {
+	unsigned int psr = enterKernel("zapWait");
 
-	procPtr proc = &ProcTable[(pid - 1) % MAXPROC];
-	if (proc->status == EMPTY){
-		if (DEBUG && debugflag)
-			USLOSS_Console("unblockProc(): attempting to unblock non existant process (pid %d does not exist).\n", pid);
-		enableInterrupts();
+	if ((mode != ZAP_WAIT_ANY && mode != ZAP_WAIT_ALL) ||
+			(Current->zapTargets == 0 && Current->numZapDone == 0)) {
+		irqRestore(psr);
 		return -2;
 	}
 
-	if (proc->status <= MEBLOCKED){
+	// quit() of the last (or any) target wakes us
+	if (Current->zapTargets != 0 && (mode == ZAP_WAIT_ALL || Current->numZapDone == 0)) {
 		if (DEBUG && debugflag)
-			USLOSS_Console("unblockProc(): attempting to unblock process %d with status (%d) <= 10 (not meblocked)\n", pid, proc->status);
-		enableInterrupts();
-		return -2;
+			USLOSS_Console("zapWait(): %d waiting for zapped processes\n", Current->pid);
+		Current->zapWaitMode = mode;
+		setStatus(Current, ZAPBLOCKED);
+		dispatcher();
+		Current->zapWaitMode = 0;
 	}
 
-	if (DEBUG && debugflag)
-		USLOSS_Console("unblockProc(): unblocking process %d.\n", pid);
-
-
-	proc->status = READY; //change status to ready
-
-	if (!onReadyList(pid, proc->priority)){ //add to readylist if not already there
-		if (DEBUG && debugflag)
-			USLOSS_Console("unblockProc(): process %d not found on ready list[%d], adding now.\n", pid, proc->priority);
-		addProcToReadyLists((pid - 1) % MAXPROC, proc->priority); //procSlot, priority
+	int result;
+	if (mode == ZAP_WAIT_ALL) {
+		result = Current->numZapDone;
+		Current->numZapDone = 0;
+	}
+	else {
+		result = Current->zapDone[0];
+		Current->numZapDone--;
+		memmove(Current->zapDone, Current->zapDone + 1, Current->numZapDone * sizeof(int));
 	}
 
-	dispatcher();
-
-	if (isZapped()){
-		enableInterrupts();
+	irqRestore(psr);
+	if (isZapped()) {
 		return -1;
 	}
-	
-	enableInterrupts();
-	return 0;
+	return result;
 }
 
+/* ------------------------------------------------------------------------
+	 Name - zapTree
+	 Purpose - Zap a process and all of its descendants at once, and wait
+						 until every one of them has quit.
+	 Parameters - the pid of the root of the tree to zap
+	 Returns - -1 if the calling process itself was zapped while waiting,
+						 0 otherwise
+	 Side Effects - every process in the tree is marked as zapped.  Those
+									blocked in blockMe() or waitEvent() are woken so they
+									can see it; those in join() wake as their children
+									quit, since the tree quits from the leaves up.  The
+									caller is blocked as ZAPBLOCKED until the tree is gone.
+	 ------------------------------------------------------------------------ */
+int zapTree(int pid) {
+	unsigned int psr = enterKernel("zapTree");
 
-int readtime(void) {
-	int status = 0;
-	int dev_status = USLOSS_DeviceInput(USLOSS_CLOCK_DEV, 0, &status);//
+	procPtr root = pid < 1 ? NULL : &ProcTable[(pid - 1) % MAXPROC];
+	if (root == NULL || root->status == EMPTY || root->status == DEAD || root->pid != pid) {
+		fprintf(stderr, "zapTree(): process being zapped does not exist.  Halting...\n");
+		USLOSS_Halt(1);
+	}
 
-	if (dev_status == USLOSS_DEV_OK) {
-		return status;
-	} else {
+	// Collect the live tree breadth first; quit children are not on child lists
+	procPtr tree[MAXPROC];
+	int size = 0;
+	if (root->status != QUIT) {
+		tree[size++] = root;
+	}
+	for (int i = 0; i < size; i++) {
+		if (tree[i] == Current) {
+			fprintf(stderr, "zapTree(): process %d tried to zap itself.  Halting...\n", Current->pid);
+			USLOSS_Halt(1);
+		}
+		for (procPtr child = tree[i]->childProcPtr; child != NULL; child = child->nextSiblingPtr) {
+			tree[size++] = child;
+		}
+	}
+
+	unsigned long long myBit = 1ULL << ((Current->pid - 1) % MAXPROC);
+	for (int i = 0; i < size; i++) {
+		procPtr proc = tree[i];
+		markZapped(proc);
+		// parents in join() are left to be woken by a quitting child
+		if (proc->status > MEBLOCKED) {
+			makeReady(proc);
+		}
+		proc->treeZappers |= myBit;
+		Current->treeZapsLeft++;
+	}
+
+	if (DEBUG && debugflag)
+		USLOSS_Console("zapTree(): %d zapped %d processes under %d\n", Current->pid, size, pid);
+
+	if (Current->treeZapsLeft > 0) {
+		setStatus(Current, ZAPBLOCKED);
+		dispatcher();
+	}
+
+	irqRestore(psr);
+	if (isZapped()) {
+		return -1;
+	}
+	return 0;
+}
+
+/*
+	Records that the process with the given pid, zapped by proc with
+	zapAsync, has quit, and wakes proc if it is waiting for it in zapWait
+*/
+void zapCompleted(procPtr proc, int pid) {
+	proc->zapDone[proc->numZapDone++] = pid; // zapAsync() keeps this in bounds
+
+	if (proc->status == ZAPBLOCKED && proc->zapWaitMode != 0 &&
+			(proc->zapWaitMode == ZAP_WAIT_ANY || proc->zapTargets == 0)) {
+		makeReady(proc);
+	}
+}
+
+int isZapped(void) {
+	return Current->zapped;
+}
+
+int getpid(void) {
+	return Current->pid;
+}
+
+/* ------------------------------------------------------------------------
+	 Name - getProcStats
+	 Purpose - Reports how a process has been scheduled: CPU time, time
+						 spent waiting for the CPU or blocked, and how often it was
+						 switched in and out.
+	 Parameters - pid of the process, and where to store its statistics
+	 Returns - -2 if stats is NULL or there is no process pid, 0 otherwise
+	 Side Effects - brings pid's accounting up to the current time
+	 ----------------------------------------------------------------------- */
+int getProcStats(int pid, procStats *stats) {
+	unsigned int psr = enterKernel("getProcStats");
+
+	procPtr proc = &ProcTable[(pid - 1) % MAXPROC];
+	if (stats == NULL || pid < 1 || proc->pid != pid ||
+			proc->status == EMPTY || proc->status == DEAD) {
+		irqRestore(psr);
+		return -2;
+	}
+
+	// charge the wait or block in progress up to now; the current run is
+	// added below instead, as startTime also times the slice
+	long long now = readtimePrecise();
+	if (proc != Current && proc->status != QUIT) {
+		if (proc->status == READY || proc->status == RUNNING) {
+			proc->readyTime += now - proc->stateSince;
+		}
+		else {
+			*blockedTimeFor(proc) += now - proc->stateSince;
+		}
+		proc->stateSince = now;
+	}
+
+	stats->pid = pid;
+	stats->cpuTime = proc->totalTimeUsed;
+	if (proc == Current) {
+		stats->cpuTime += now - proc->startTime;
+	}
+	stats->readyTime = proc->readyTime;
+	stats->joinBlockedTime = proc->joinBlockedTime;
+	stats->zapBlockedTime = proc->zapBlockedTime;
+	stats->meBlockedTime = proc->meBlockedTime;
+	stats->syncBlockedTime = proc->syncBlockedTime;
+	stats->dispatches = proc->dispatches;
+	stats->voluntarySwitches = proc->voluntarySwitches;
+	stats->involuntarySwitches = proc->involuntarySwitches;
+
+	irqRestore(psr);
+	return 0;
+}
+
+int blockMe(int block_status) {
+	unsigned int psr = enterKernel("blockMe");
+
+	if (block_status <= MEBLOCKED){
+		USLOSS_Console("blockMe(): cannot block process with status (%d) <= 10. Halting...\n", block_status);
+		USLOSS_Halt(1);
+	}
+
+	return blockCurrent(block_status, 0, psr);
+}
+
+/* ------------------------------------------------------------------------
+	 Name - blockMeTimeout
+	 Purpose - Like blockMe, but the process is also woken once timeout
+						 microseconds have passed.  The timeout is expired by
+						 clockHandler(), so it is only as precise as the clock
+						 interrupt.
+	 Parameters - the status to block with (> MEBLOCKED) and the timeout in
+								microseconds (<= 0 waits forever)
+	 Returns - 0 if unblocked by unblockProc
+						 -1 if the process was zapped
+						 -3 if the timeout expired first
+	 Side Effects - the caller is blocked until unblocked or timed out
+	 ------------------------------------------------------------------------ */
+int blockMeTimeout(int block_status, int timeout) {
+	unsigned int psr = enterKernel("blockMeTimeout");
+
+	if (block_status <= MEBLOCKED){
+		USLOSS_Console("blockMeTimeout(): cannot block process with status (%d) <= 10. Halting...\n", block_status);
+		USLOSS_Halt(1);
+	}
+
+	return blockCurrent(block_status, timeout, psr);
+}
+
+/* ------------------------------------------------------------------------
+	 Name - sleepMe
+	 Purpose - Blocks the caller for at least usec microseconds.  It is
+						 woken from clockHandler() when its timer on the timer wheel
+						 fires, so it uses no CPU while asleep.
+	 Parameters - the number of microseconds to sleep
+	 Returns - 0 after sleeping, -1 if the process was zapped
+	 Side Effects - the caller is blocked as SLEEPBLOCKED
+	 ------------------------------------------------------------------------ */
+int sleepMe(int usec) {
+	unsigned int psr = enterKernel("sleepMe");
+
+	if (usec > 0) {
+		if (DEBUG && debugflag)
+			USLOSS_Console("sleepMe(): %d sleeping for %d usec\n", Current->pid, usec);
+		armTimer(Current, refreshKernelTime() + usec);
+		setStatus(Current, SLEEPBLOCKED);
+		dispatcher();
+		cancelTimer(Current);
+		Current->timedOut = 0;
+	}
+
+	irqRestore(psr);
+	if (isZapped()) {
+		return -1;
+	}
+	return 0;
+}
+
+/*
+	Blocks Current with block_status until unblockProc, or until timeout
+	microseconds pass if timeout > 0, then ends the caller's irqSave()
+	section.  Returns as blockMeTimeout.
+*/
+static int blockCurrent(int block_status, int timeout, unsigned int psr) {
+	if (timeout > 0) {
+		armTimer(Current, refreshKernelTime() + timeout);
+	}
+	setStatus(Current, block_status);
+	dispatcher();
+	cancelTimer(Current);
+
+	int timedOut = Current->timedOut;
+	Current->timedOut = 0;
+	irqRestore(psr);
+	if (isZapped()){
+		return -1;
+	}
+	if (timedOut) {
+		return -3;
+	}
+	return 0;
+}
+
+int unblockProc(int pid) {
+	unsigned int psr = enterKernel("unblockProc");
+
+	//returns -2 if proc is the current process, does not exist, not me-blocked, or blocked on status <= 10
+	if (pid == Current->pid){
+		if (DEBUG && debugflag)
+			USLOSS_Console("unblockProc(): attempting to unblock Current process (pid %d).\n", pid);
+		irqRestore(psr);
+		return -2;
+	}
+
+	procPtr proc = &ProcTable[(pid - 1) % MAXPROC];
+	if (proc->status == EMPTY || proc->status == DEAD){
+		if (DEBUG && debugflag)
+			USLOSS_Console("unblockProc(): attempting to unblock non existant process (pid %d does not exist).\n", pid);
+		irqRestore(psr);
+		return -2;
+	}
+
+	if (proc->status == WAITBLOCKED) {
+		if (DEBUG && debugflag)
+			USLOSS_Console("unblockProc(): waking process %d from waitEvent.\n", pid);
+		proc->wakeEvent = WAIT_UNBLOCKED;
+	}
+	else if (proc->status <= MEBLOCKED){
+		if (DEBUG && debugflag)
+			USLOSS_Console("unblockProc(): attempting to unblock process %d with status (%d) <= 10 (not meblocked)\n", pid, proc->status);
+		irqRestore(psr);
+		return -2;
+	}
+
+	if (DEBUG && debugflag)
+		USLOSS_Console("unblockProc(): unblocking process %d.\n", pid);
+
+
+	makeReady(proc); //change status to ready
+
+	if (!onReadyList(pid, proc->priority)){ //add to readylist if not already there
+		if (DEBUG && debugflag)
+			USLOSS_Console("unblockProc(): process %d not found on ready list[%d], adding now.\n", pid, proc->priority);
+		addProcToReadyLists((pid - 1) % MAXPROC, proc->priority); //procSlot, priority
+	}
+
+	dispatcher();
+
+	if (isZapped()){
+		irqRestore(psr);
+		return -1;
+	}
+	
+	irqRestore(psr);
+	return 0;
+}
+
+
+/* ------------------------------------------------------------------------
+	 Name - semCreate
+	 Purpose - Creates a counting semaphore with a FIFO queue of waiters.
+	 Parameters - the initial value of the semaphore
+	 Returns - the id of the semaphore, or -1 if the value is negative or
+						 all MAXSEMAPHORES semaphores are in use
+	 Side Effects - an entry of SemTable is taken
+	 ------------------------------------------------------------------------ */
+int semCreate(int value) {
+	unsigned int psr = enterKernel("semCreate");
+
+	if (value < 0) {
+		irqRestore(psr);
+		return -1;
+	}
+
+	for (int i = 0; i < MAXSEMAPHORES; i++) {
+		if (!SemTable[i].inUse) {
+			SemTable[i].inUse = 1;
+			SemTable[i].value = value;
+			initWaitQueue(&SemTable[i].waiters);
+			irqRestore(psr);
+			return i;
+		}
+	}
+
+	if (DEBUG && debugflag)
+		USLOSS_Console("semCreate(): no free semaphores\n");
+	irqRestore(psr);
+	return -1;
+}
+
+/* ------------------------------------------------------------------------
+	 Name - semP
+	 Purpose - Decrements a semaphore, blocking in FIFO order while its
+						 value is 0.  A semV hands its unit straight to the first
+						 waiter, so a woken process never has to retry.
+	 Parameters - the id of the semaphore
+	 Returns - 0 once the semaphore has been decremented
+						 -1 if the process was zapped (it still holds the unit)
+						 -2 if the id is invalid or the semaphore was freed while
+								waiting
+	 Side Effects - the caller may be blocked as SYNCBLOCKED
+	 ------------------------------------------------------------------------ */
+int semP(int id) {
+	unsigned int psr = enterKernel("semP");
+
+	if (id < 0 || id >= MAXSEMAPHORES || !SemTable[id].inUse) {
+		irqRestore(psr);
+		return -2;
+	}
+
+	int result = 0;
+	if (SemTable[id].value > 0) {
+		SemTable[id].value--;
+	}
+	else {
+		result = waitOn(&SemTable[id].waiters);
+	}
+
+	irqRestore(psr);
+	if (result == 0 && isZapped()) {
+		return -1;
+	}
+	return result;
+}
+
+/* ------------------------------------------------------------------------
+	 Name - semV
+	 Purpose - Increments a semaphore, or passes the unit to its first
+						 waiter.  The dispatcher only runs if that waiter has a
+						 higher priority than the caller.
+	 Parameters - the id of the semaphore
+	 Returns - 0 on success, -2 if the id is invalid
+	 Side Effects - a waiting process may be made READY
+	 ------------------------------------------------------------------------ */
+int semV(int id) {
+	unsigned int psr = enterKernel("semV");
+
+	if (id < 0 || id >= MAXSEMAPHORES || !SemTable[id].inUse) {
+		irqRestore(psr);
+		return -2;
+	}
+
+	procPtr proc = wakeOne(&SemTable[id].waiters, 0);
+	if (proc == NULL) {
+		SemTable[id].value++;
+	}
+	else {
+		preemptFor(proc->priority);
+	}
+
+	irqRestore(psr);
+	return 0;
+}
+
+/* ------------------------------------------------------------------------
+	 Name - semFree
+	 Purpose - Releases a semaphore.  Processes still waiting on it are
+						 woken and their semP returns -2.
+	 Parameters - the id of the semaphore
+	 Returns - 0 if nobody was waiting, 1 if waiters were woken, -2 if the
+						 id is invalid
+	 Side Effects - the SemTable entry becomes free
+	 ------------------------------------------------------------------------ */
+int semFree(int id) {
+	unsigned int psr = enterKernel("semFree");
+
+	if (id < 0 || id >= MAXSEMAPHORES || !SemTable[id].inUse) {
+		irqRestore(psr);
+		return -2;
+	}
+
+	SemTable[id].inUse = 0;
+	int hadWaiters = SemTable[id].waiters.count > 0;
+	if (hadWaiters) {
+		preemptFor(wakeAllWithResult(&SemTable[id].waiters, -2));
+	}
+
+	irqRestore(psr);
+	return hadWaiters;
+}
+
+/*
+	Blocks Current as SYNCBLOCKED at the tail of a wait queue until a
+	waker takes it off.  Returns the result left by the waker.
+*/
+int waitOn(waitQueue *queue) {
+	Current->waitResult = 0;
+	enqueueWaiter(queue, Current);
+	setStatus(Current, SYNCBLOCKED);
+	dispatcher();
+	return Current->waitResult;
+}
+
+/*
+	Makes the first process of a wait queue READY with the given result
+	for waitOn.  Returns the process woken, or NULL if there was none.
+*/
+procPtr wakeOne(waitQueue *queue, int result) {
+	procPtr proc = dequeueWaiter(queue);
+	if (proc != NULL) {
+		proc->waitResult = result;
+		makeReady(proc);
+	}
+	return proc;
+}
+
+/*
+	Like wakeAllWaiters, but also leaves a result for each waitOn
+*/
+int wakeAllWithResult(waitQueue *queue, int result) {
+	for (procPtr proc = queue->head; proc != NULL; proc = proc->waitNext) {
+		proc->waitResult = result;
+	}
+	return wakeAllWaiters(queue);
+}
+
+/*
+	Runs the dispatcher only if a process of the given priority should
+	take the CPU from Current
+*/
+void preemptFor(int priority) {
+	if (priority < Current->priority) {
+		dispatcher();
+	}
+}
+
+/* ------------------------------------------------------------------------
+	 Name - mutexCreate
+	 Purpose - Creates a mutex that tracks its owner.  With
+						 MUTEX_PRIO_INHERIT, an owner runs at the priority of the
+						 best process waiting for it.
+	 Parameters - 0 or MUTEX_PRIO_INHERIT
+	 Returns - the id of the mutex, or -1 if all MAXMUTEXES are in use
+	 Side Effects - an entry of MutexTable is taken
+	 ------------------------------------------------------------------------ */
+int mutexCreate(int flags) {
+	unsigned int psr = enterKernel("mutexCreate");
+
+	for (int i = 0; i < MAXMUTEXES; i++) {
+		if (!MutexTable[i].inUse) {
+			MutexTable[i].inUse = 1;
+			MutexTable[i].flags = flags;
+			MutexTable[i].owner = NULL;
+			MutexTable[i].heldNext = NULL;
+			MutexTable[i].heldPrev = NULL;
+			initWaitQueue(&MutexTable[i].waiters);
+			irqRestore(psr);
+			return i;
+		}
+	}
+
+	if (DEBUG && debugflag)
+		USLOSS_Console("mutexCreate(): no free mutexes\n");
+	irqRestore(psr);
+	return -1;
+}
+
+/* ------------------------------------------------------------------------
+	 Name - mutexLock
+	 Purpose - Takes a mutex, waiting in FIFO order while another process
+						 owns it.  Ownership is handed over by the unlocker, so a
+						 woken process never has to retry.
+	 Parameters - the id of the mutex
+	 Returns - 0 once the caller owns the mutex
+						 -1 if the process was zapped (it still owns the mutex)
+						 -2 if the id is invalid, the caller already owns it, or it
+								was freed while waiting
+	 Side Effects - the caller may be blocked as SYNCBLOCKED, and the owner's
+									priority may be raised
+	 ------------------------------------------------------------------------ */
+int mutexLock(int id) {
+	unsigned int psr = enterKernel("mutexLock");
+
+	if (id < 0 || id >= MAXMUTEXES || !MutexTable[id].inUse || MutexTable[id].owner == Current) {
+		irqRestore(psr);
+		return -2;
+	}
+
+	int result = lockMutex(id);
+
+	irqRestore(psr);
+	if (result == 0 && isZapped()) {
+		return -1;
+	}
+	return result;
+}
+
+/* ------------------------------------------------------------------------
+	 Name - mutexUnlock
+	 Purpose - Releases a mutex owned by the caller, handing it to the
+						 first waiter.
+	 Parameters - the id of the mutex
+	 Returns - 0 on success, -2 if the id is invalid or the caller is not
+						 the owner
+	 Side Effects - a waiting process may be made READY; an inherited
+									priority is given back
+	 ------------------------------------------------------------------------ */
+int mutexUnlock(int id) {
+	unsigned int psr = enterKernel("mutexUnlock");
+
+	if (id < 0 || id >= MAXMUTEXES || !MutexTable[id].inUse || MutexTable[id].owner != Current) {
+		irqRestore(psr);
+		return -2;
+	}
+
+	procPtr next = unlockMutex(id);
+	if (next != NULL) {
+		preemptFor(next->priority);
+	}
+
+	irqRestore(psr);
+	return 0;
+}
+
+/* ------------------------------------------------------------------------
+	 Name - mutexFree
+	 Purpose - Releases a mutex.  Processes still waiting on it are woken
+						 and their mutexLock returns -2.
+	 Parameters - the id of the mutex
+	 Returns - 0 if nobody was waiting, 1 if waiters were woken, -2 if the
+						 id is invalid
+	 Side Effects - the MutexTable entry becomes free
+	 ------------------------------------------------------------------------ */
+int mutexFree(int id) {
+	unsigned int psr = enterKernel("mutexFree");
+
+	if (id < 0 || id >= MAXMUTEXES || !MutexTable[id].inUse) {
+		irqRestore(psr);
+		return -2;
+	}
+
+	procPtr owner = MutexTable[id].owner;
+	MutexTable[id].inUse = 0;
+	setMutexOwner(&MutexTable[id], NULL);
+	int hadWaiters = MutexTable[id].waiters.count > 0;
+	int best = wakeAllWithResult(&MutexTable[id].waiters, -2);
+	if (owner != NULL && owner->priority != owner->basePriority) {
+		restorePriority(owner);
+	}
+	preemptFor(best);
+
+	irqRestore(psr);
+	return hadWaiters;
+}
+
+/* ------------------------------------------------------------------------
+	 Name - condCreate
+	 Purpose - Creates a condition variable
+	 Parameters - none
+	 Returns - the id of the condition variable, or -1 if all MAXCONDS are
+						 in use
+	 Side Effects - an entry of CondTable is taken
+	 ------------------------------------------------------------------------ */
+int condCreate(void) {
+	unsigned int psr = enterKernel("condCreate");
+
+	for (int i = 0; i < MAXCONDS; i++) {
+		if (!CondTable[i].inUse) {
+			CondTable[i].inUse = 1;
+			initWaitQueue(&CondTable[i].waiters);
+			irqRestore(psr);
+			return i;
+		}
+	}
+
+	if (DEBUG && debugflag)
+		USLOSS_Console("condCreate(): no free condition variables\n");
+	irqRestore(psr);
+	return -1;
+}
+
+/* ------------------------------------------------------------------------
+	 Name - condWait
+	 Purpose - Atomically releases a mutex owned by the caller and waits on
+						 a condition variable.  Returns owning the mutex again.
+	 Parameters - the ids of the condition variable and of the mutex
+	 Returns - 0 once signaled and owning the mutex
+						 -1 if the process was zapped (it still owns the mutex)
+						 -2 if an id is invalid, the caller does not own the
+								mutex, or either was freed while waiting (the caller
+								does not own the mutex then)
+	 Side Effects - the caller is blocked as SYNCBLOCKED
+	 ------------------------------------------------------------------------ */
+int condWait(int cond, int mutex) {
+	unsigned int psr = enterKernel("condWait");
+
+	if (cond < 0 || cond >= MAXCONDS || !CondTable[cond].inUse ||
+			mutex < 0 || mutex >= MAXMUTEXES || !MutexTable[mutex].inUse ||
+			MutexTable[mutex].owner != Current) {
+		irqRestore(psr);
+		return -2;
+	}
+
+	unlockMutex(mutex);
+	Current->condMutex = mutex;
+	int result = waitOn(&CondTable[cond].waiters);
+	Current->condMutex = -1;
+	Current->waitMutex = -1;
+
+	irqRestore(psr);
+	if (result == 0 && isZapped()) {
+		return -1;
+	}
+	return result;
+}
+
+/* ------------------------------------------------------------------------
+	 Name - condSignal
+	 Purpose - Wakes the first process waiting on a condition variable.
+						 If its mutex is owned, the waiter is moved straight onto
+						 the mutex's wait queue instead of waking only to block
+						 again.
+	 Parameters - the id of the condition variable
+	 Returns - 0 on success, -2 if the id is invalid
+	 Side Effects - a waiting process may be made READY
+	 ------------------------------------------------------------------------ */
+int condSignal(int cond) {
+	unsigned int psr = enterKernel("condSignal");
+
+	if (cond < 0 || cond >= MAXCONDS || !CondTable[cond].inUse) {
+		irqRestore(psr);
+		return -2;
+	}
+
+	procPtr proc = dequeueWaiter(&CondTable[cond].waiters);
+	if (proc != NULL) {
+		preemptFor(moveToMutex(proc));
+	}
+
+	irqRestore(psr);
+	return 0;
+}
+
+/* ------------------------------------------------------------------------
+	 Name - condBroadcast
+	 Purpose - Wakes every process waiting on a condition variable, moving
+						 them onto their mutex's wait queue as condSignal does.
+	 Parameters - the id of the condition variable
+	 Returns - 0 on success, -2 if the id is invalid
+	 Side Effects - waiting processes may be made READY; the dispatcher runs
+									at most once
+	 ------------------------------------------------------------------------ */
+int condBroadcast(int cond) {
+	unsigned int psr = enterKernel("condBroadcast");
+
+	if (cond < 0 || cond >= MAXCONDS || !CondTable[cond].inUse) {
+		irqRestore(psr);
+		return -2;
+	}
+
+	int best = SENTINELPRIORITY + 1;
+	procPtr proc;
+	while ((proc = dequeueWaiter(&CondTable[cond].waiters)) != NULL) {
+		int priority = moveToMutex(proc);
+		if (priority < best) {
+			best = priority;
+		}
+	}
+	preemptFor(best);
+
+	irqRestore(psr);
+	return 0;
+}
+
+/* ------------------------------------------------------------------------
+	 Name - condFree
+	 Purpose - Releases a condition variable.  Processes still waiting on
+						 it are woken and their condWait returns -2.
+	 Parameters - the id of the condition variable
+	 Returns - 0 if nobody was waiting, 1 if waiters were woken, -2 if the
+						 id is invalid
+	 Side Effects - the CondTable entry becomes free
+	 ------------------------------------------------------------------------ */
+int condFree(int cond) {
+	unsigned int psr = enterKernel("condFree");
+
+	if (cond < 0 || cond >= MAXCONDS || !CondTable[cond].inUse) {
+		irqRestore(psr);
+		return -2;
+	}
+
+	CondTable[cond].inUse = 0;
+	int hadWaiters = CondTable[cond].waiters.count > 0;
+	preemptFor(wakeAllWithResult(&CondTable[cond].waiters, -2));
+
+	irqRestore(psr);
+	return hadWaiters;
+}
+
+/* ------------------------------------------------------------------------
+	 Name - blockOn
+	 Purpose - Blocks the caller until wakeAddr is called on addr, but only
+						 if *addr still equals expected.  The comparison and the
+						 block happen with interrupts off, so a wakeAddr between a
+						 caller's own test and its call cannot be lost.
+	 Parameters - the address to wait on and the value it must hold
+	 Returns - 0 if woken by wakeAddr
+						 -1 if the process was zapped
+						 -2 if addr is NULL
+						 -3 if *addr did not equal expected (the caller did not block)
+	 Side Effects - the caller may be blocked as SYNCBLOCKED
+	 ------------------------------------------------------------------------ */
+int blockOn(int *addr, int expected) {
+	unsigned int psr = enterKernel("blockOn");
+
+	if (addr == NULL) {
+		irqRestore(psr);
+		return -2;
+	}
+
+	if (*addr != expected) {
+		irqRestore(psr);
+		return -3;
+	}
+
+	Current->waitAddr = addr;
+	int result = waitOn(&AddrWaiters[addrBucket(addr)]);
+	Current->waitAddr = NULL;
+
+	irqRestore(psr);
+	if (result == 0 && isZapped()) {
+		return -1;
+	}
+	return result;
+}
+
+/* ------------------------------------------------------------------------
+	 Name - wakeAddr
+	 Purpose - Wakes up to n processes blocked on addr, in the order they
+						 blocked.
+	 Parameters - the address and the maximum number of processes to wake
+	 Returns - the number of processes woken, or -2 if addr is NULL
+	 Side Effects - the dispatcher runs at most once, and only if a woken
+									process has a higher priority than the caller
+	 ------------------------------------------------------------------------ */
+int wakeAddr(int *addr, int n) {
+	unsigned int psr = enterKernel("wakeAddr");
+
+	if (addr == NULL) {
+		irqRestore(psr);
+		return -2;
+	}
+
+	waitQueue *queue = &AddrWaiters[addrBucket(addr)];
+	int woken = 0;
+	int best = SENTINELPRIORITY + 1;
+	procPtr prev = NULL;
+	procPtr proc = queue->head;
+	while (proc != NULL && woken < n) {
+		procPtr next = proc->waitNext;
+		if (proc->waitAddr == addr) {
+			removeWaiter(queue, prev, proc);
+			proc->waitResult = 0;
+			makeReady(proc);
+			if (proc->priority < best) {
+				best = proc->priority;
+			}
+			woken++;
+		}
+		else {
+			prev = proc;
+		}
+		proc = next;
+	}
+	preemptFor(best);
+
+	irqRestore(psr);
+	return woken;
+}
+
+/* ------------------------------------------------------------------------
+	 Name - chanCreate
+	 Purpose - Creates a channel holding up to capacity int messages, for
+						 any number of senders and receivers.
+	 Parameters - the capacity of the channel, 1 to MAXCHANSLOTS
+	 Returns - the id of the channel, or -1 if the capacity is out of range
+						 or all MAXCHANNELS are in use
+	 Side Effects - an entry of ChanTable is taken
+	 ------------------------------------------------------------------------ */
+int chanCreate(int capacity) {
+	unsigned int psr = enterKernel("chanCreate");
+
+	if (capacity < 1 || capacity > MAXCHANSLOTS) {
+		irqRestore(psr);
+		return -1;
+	}
+
+	for (int i = 0; i < MAXCHANNELS; i++) {
+		if (!ChanTable[i].inUse) {
+			ChanTable[i].inUse = 1;
+			ChanTable[i].capacity = capacity;
+			ChanTable[i].head = 0;
+			ChanTable[i].count = 0;
+			initWaitQueue(&ChanTable[i].senders);
+			initWaitQueue(&ChanTable[i].receivers);
+			irqRestore(psr);
+			return i;
+		}
+	}
+
+	if (DEBUG && debugflag)
+		USLOSS_Console("chanCreate(): no free channels\n");
+	irqRestore(psr);
+	return -1;
+}
+
+/* ------------------------------------------------------------------------
+	 Name - chanSend
+	 Purpose - Sends one message on a channel, blocking while it is full
+	 Parameters - the id of the channel and the message
+	 Returns - as chanSendMany
+	 Side Effects - as chanSendMany
+	 ------------------------------------------------------------------------ */
+int chanSend(int id, int msg) {
+	return sendMessages(id, &msg, 1, "chanSend");
+}
+
+/* ------------------------------------------------------------------------
+	 Name - chanSendMany
+	 Purpose - Sends n messages on a channel in order, blocking while it is
+						 full.  Messages go straight into the buffers of waiting
+						 receivers, and only the rest are queued on the channel.
+	 Parameters - the id of the channel, the messages and how many there are
+	 Returns - n once every message has been sent
+						 -1 if the process was zapped (the messages were still sent)
+						 -2 if the id or n is invalid, or the channel was freed
+								while waiting
+	 Side Effects - the caller may be blocked as SYNCBLOCKED, and waiting
+									receivers are made READY
+	 ------------------------------------------------------------------------ */
+int chanSendMany(int id, int msgs[], int n) {
+	return sendMessages(id, msgs, n, "chanSendMany");
+}
+
+/* ------------------------------------------------------------------------
+	 Name - chanReceive
+	 Purpose - Receives one message from a channel, blocking while it is
+						 empty
+	 Parameters - the id of the channel and where to store the message
+	 Returns - as chanReceiveMany
+	 Side Effects - as chanReceiveMany
+	 ------------------------------------------------------------------------ */
+int chanReceive(int id, int *msg) {
+	return receiveMessages(id, msg, 1, "chanReceive");
+}
+
+/* ------------------------------------------------------------------------
+	 Name - chanReceiveMany
+	 Purpose - Receives up to max messages from a channel, blocking while
+						 it is empty.  Room freed in the channel is refilled from
+						 blocked senders before returning.
+	 Parameters - the id of the channel, where to store the messages and
+								how many fit there
+	 Returns - the number of messages received, at least 1
+						 -1 if the process was zapped (the messages were still
+								received)
+						 -2 if the id or max is invalid, or the channel was freed
+								while waiting
+	 Side Effects - the caller may be blocked as SYNCBLOCKED, and blocked
+									senders are made READY once all of their messages
+									are in the channel
+	 ------------------------------------------------------------------------ */
+int chanReceiveMany(int id, int msgs[], int max) {
+	return receiveMessages(id, msgs, max, "chanReceiveMany");
+}
+
+/* ------------------------------------------------------------------------
+	 Name - chanFree
+	 Purpose - Releases a channel.  Processes blocked sending or receiving
+						 on it are woken with -2, and queued messages are dropped.
+	 Parameters - the id of the channel
+	 Returns - 0 if nobody was waiting, 1 if waiters were woken, -2 if the
+						 id is invalid
+	 Side Effects - the ChanTable entry becomes free
+	 ------------------------------------------------------------------------ */
+int chanFree(int id) {
+	unsigned int psr = enterKernel("chanFree");
+
+	if (id < 0 || id >= MAXCHANNELS || !ChanTable[id].inUse) {
+		irqRestore(psr);
+		return -2;
+	}
+
+	chanStruct *chan = &ChanTable[id];
+	chan->inUse = 0;
+	int hadWaiters = chan->senders.count > 0 || chan->receivers.count > 0;
+	int best = wakeAllWithResult(&chan->senders, -2);
+	int bestReceiver = wakeAllWithResult(&chan->receivers, -2);
+	preemptFor(bestReceiver < best ? bestReceiver : best);
+
+	irqRestore(psr);
+	return hadWaiters;
+}
+
+/* ------------------------------------------------------------------------
+	 Name - barrierCreate
+	 Purpose - Creates a reusable barrier for n processes
+	 Parameters - the number of processes that must arrive, at least 1
+	 Returns - the id of the barrier, or -1 if n is invalid or all
+						 MAXBARRIERS are in use
+	 Side Effects - an entry of BarrierTable is taken
+	 ------------------------------------------------------------------------ */
+int barrierCreate(int n) {
+	unsigned int psr = enterKernel("barrierCreate");
+
+	if (n < 1) {
+		irqRestore(psr);
+		return -1;
+	}
+
+	for (int i = 0; i < MAXBARRIERS; i++) {
+		if (!BarrierTable[i].inUse) {
+			BarrierTable[i].inUse = 1;
+			BarrierTable[i].parties = n;
+			initWaitQueue(&BarrierTable[i].waiters);
+			irqRestore(psr);
+			return i;
+		}
+	}
+
+	if (DEBUG && debugflag)
+		USLOSS_Console("barrierCreate(): no free barriers\n");
+	irqRestore(psr);
+	return -1;
+}
+
+/* ------------------------------------------------------------------------
+	 Name - barrierWait
+	 Purpose - Waits until all the barrier's processes have arrived.  The
+						 last one to arrive releases the others in a single pass and
+						 the dispatcher runs at most once.  The barrier is then
+						 ready for the next step.
+	 Parameters - the id of the barrier
+	 Returns - 1 for the process that released the barrier, 0 for the others
+						 -1 if the process was zapped
+						 -2 if the id is invalid or the barrier was freed while
+								waiting
+	 Side Effects - the caller may be blocked as SYNCBLOCKED
+	 ------------------------------------------------------------------------ */
+int barrierWait(int id) {
+	unsigned int psr = enterKernel("barrierWait");
+
+	if (id < 0 || id >= MAXBARRIERS || !BarrierTable[id].inUse) {
+		irqRestore(psr);
+		return -2;
+	}
+
+	barrierStruct *barrier = &BarrierTable[id];
+	int result;
+	if (barrier->waiters.count + 1 < barrier->parties) {
+		result = waitOn(&barrier->waiters);
+	}
+	else {
+		if (DEBUG && debugflag)
+			USLOSS_Console("barrierWait(): %d releasing %d waiters\n", Current->pid, barrier->waiters.count);
+		preemptFor(wakeAllWithResult(&barrier->waiters, 0));
+		result = 1;
+	}
+
+	irqRestore(psr);
+	if (result >= 0 && isZapped()) {
+		return -1;
+	}
+	return result;
+}
+
+/* ------------------------------------------------------------------------
+	 Name - barrierFree
+	 Purpose - Releases a barrier.  Processes still waiting at it are woken
+						 and their barrierWait returns -2.
+	 Parameters - the id of the barrier
+	 Returns - 0 if nobody was waiting, 1 if waiters were woken, -2 if the
+						 id is invalid
+	 Side Effects - the BarrierTable entry becomes free
+	 ------------------------------------------------------------------------ */
+int barrierFree(int id) {
+	unsigned int psr = enterKernel("barrierFree");
+
+	if (id < 0 || id >= MAXBARRIERS || !BarrierTable[id].inUse) {
+		irqRestore(psr);
+		return -2;
+	}
+
+	BarrierTable[id].inUse = 0;
+	int hadWaiters = BarrierTable[id].waiters.count > 0;
+	preemptFor(wakeAllWithResult(&BarrierTable[id].waiters, -2));
+
+	irqRestore(psr);
+	return hadWaiters;
+}
+
+/*
+	Does the work for chanSend and chanSendMany, named by func.  Receivers
+	only wait on an empty channel, so they are served before anything is
+	queued.
+*/
+int sendMessages(int id, int msgs[], int n, const char *func) {
+	unsigned int psr = enterKernel(func);
+
+	if (id < 0 || id >= MAXCHANNELS || !ChanTable[id].inUse || n < 1) {
+		irqRestore(psr);
+		return -2;
+	}
+
+	chanStruct *chan = &ChanTable[id];
+	int sent = 0;
+	int best = SENTINELPRIORITY + 1;
+
+	// hand messages directly to waiting receivers
+	while (sent < n && chan->receivers.head != NULL) {
+		procPtr receiver = chan->receivers.head;
+		int give = n - sent < receiver->msgMax ? n - sent : receiver->msgMax;
+		memcpy(receiver->msgBuf, msgs + sent, give * sizeof(int));
+		receiver->msgCount = give;
+		sent += give;
+		wakeOne(&chan->receivers, 0);
+		if (receiver->priority < best) {
+			best = receiver->priority;
+		}
+	}
+
+	// queue the rest while there is room
+	while (sent < n && chan->count < chan->capacity) {
+		chan->buffer[(chan->head + chan->count) % chan->capacity] = msgs[sent++];
+		chan->count++;
+	}
+
+	int result = 0;
+	if (sent < n) {
+		// receivers move the rest into the channel and wake us when done
+		Current->msgBuf = msgs;
+		Current->msgCount = sent;
+		Current->msgMax = n;
+		result = waitOn(&chan->senders);
+		Current->msgBuf = NULL;
+	}
+	else {
+		preemptFor(best);
+	}
+
+	irqRestore(psr);
+	if (result != 0) {
+		return result;
+	}
+	if (isZapped()) {
+		return -1;
+	}
+	return n;
+}
+
+/*
+	Does the work for chanReceive and chanReceiveMany, named by func.
+	Senders only wait on a full channel, so an empty channel has no senders
+	to take from.
+*/
+int receiveMessages(int id, int msgs[], int max, const char *func) {
+	unsigned int psr = enterKernel(func);
+
+	if (id < 0 || id >= MAXCHANNELS || !ChanTable[id].inUse || max < 1) {
+		irqRestore(psr);
+		return -2;
+	}
+
+	chanStruct *chan = &ChanTable[id];
+	int received = 0;
+
+	if (chan->count == 0) {
+		// a sender will copy straight into msgs and wake us
+		Current->msgBuf = msgs;
+		Current->msgCount = 0;
+		Current->msgMax = max;
+		int result = waitOn(&chan->receivers);
+		Current->msgBuf = NULL;
+		if (result != 0) {
+			irqRestore(psr);
+			return result;
+		}
+		received = Current->msgCount;
+	}
+	else {
+		while (received < max && chan->count > 0) {
+			msgs[received++] = chan->buffer[chan->head];
+			chan->head = (chan->head + 1) % chan->capacity;
+			chan->count--;
+		}
+
+		// refill from blocked senders, keeping their messages in order
+		int best = SENTINELPRIORITY + 1;
+		while (chan->senders.head != NULL && chan->count < chan->capacity) {
+			procPtr sender = chan->senders.head;
+			while (sender->msgCount < sender->msgMax && chan->count < chan->capacity) {
+				chan->buffer[(chan->head + chan->count) % chan->capacity] = sender->msgBuf[sender->msgCount++];
+				chan->count++;
+			}
+			if (sender->msgCount == sender->msgMax) {
+				wakeOne(&chan->senders, 0);
+				if (sender->priority < best) {
+					best = sender->priority;
+				}
+			}
+		}
+		preemptFor(best);
+	}
+
+	irqRestore(psr);
+	if (isZapped()) {
+		return -1;
+	}
+	return received;
+}
+
+/*
+	Hashes an address to its AddrWaiters bucket
+*/
+int addrBucket(int *addr) {
+	return (int) (((unsigned long) addr >> 2) % ADDRBUCKETS);
+}
+
+/*
+	Takes mutex id for Current, blocking until it is handed over if it is
+	owned.  Returns the waitOn result.
+*/
+int lockMutex(int id) {
+	mutexStruct *mutex = &MutexTable[id];
+	if (mutex->owner == NULL) {
+		setMutexOwner(mutex, Current);
+		return 0;
+	}
+
+	if (mutex->flags & MUTEX_PRIO_INHERIT) {
+		inheritPriority(mutex->owner, Current->priority);
+	}
+	Current->waitMutex = id;
+	int result = waitOn(&mutex->waiters);
+	Current->waitMutex = -1;
+	return result;
+}
+
+/*
+	Gives mutex id, owned by Current, to its first waiter and drops any
+	priority Current inherited through it.  Returns the new owner, or NULL.
+*/
+procPtr unlockMutex(int id) {
+	mutexStruct *mutex = &MutexTable[id];
+	procPtr next = wakeOne(&mutex->waiters, 0);
+	setMutexOwner(mutex, next);
+	if (Current->priority != Current->basePriority) {
+		restorePriority(Current);
+	}
+	return next;
+}
+
+/*
+	Moves mutex to owner, or to no one if owner is NULL, keeping each
+	process's list of the mutexes it holds
+*/
+void setMutexOwner(mutexStruct *mutex, procPtr owner) {
+	if (mutex->owner != NULL) {
+		if (mutex->heldPrev == NULL) {
+			mutex->owner->heldMutexes = mutex->heldNext;
+		}
+		else {
+			mutex->heldPrev->heldNext = mutex->heldNext;
+		}
+		if (mutex->heldNext != NULL) {
+			mutex->heldNext->heldPrev = mutex->heldPrev;
+		}
+	}
+
+	mutex->owner = owner;
+	mutex->heldPrev = NULL;
+	mutex->heldNext = NULL;
+	if (owner != NULL) {
+		mutex->heldNext = owner->heldMutexes;
+		if (owner->heldMutexes != NULL) {
+			owner->heldMutexes->heldPrev = mutex;
+		}
+		owner->heldMutexes = mutex;
+	}
+}
+
+/*
+	Hands a process taken off a condition variable to the mutex it has to
+	reacquire: it is woken if the mutex is free, else it waits on the mutex
+	without running.  Returns the priority woken, or SENTINELPRIORITY + 1.
+*/
+int moveToMutex(procPtr proc) {
+	mutexStruct *mutex = &MutexTable[proc->condMutex];
+	if (!mutex->inUse) {
+		proc->waitResult = -2;
+	}
+	else if (mutex->owner != NULL) {
+		proc->waitMutex = proc->condMutex;
+		enqueueWaiter(&mutex->waiters, proc);
+		if (mutex->flags & MUTEX_PRIO_INHERIT) {
+			inheritPriority(mutex->owner, proc->priority);
+		}
+		return SENTINELPRIORITY + 1;
+	}
+	else {
+		setMutexOwner(mutex, proc);
+		proc->waitResult = 0;
+	}
+	makeReady(proc);
+	return proc->priority;
+}
+
+/*
+	Raises owner to priority, and the owners of any inheriting mutexes it
+	is itself waiting for
+*/
+void inheritPriority(procPtr owner, int priority) {
+	for (int i = 0; i < MAXPROC && owner != NULL && priority < owner->priority; i++) {
+		setPriority(owner, priority);
+		if (owner->status != SYNCBLOCKED || owner->waitMutex == -1 ||
+				!(MutexTable[owner->waitMutex].flags & MUTEX_PRIO_INHERIT)) {
+			break;
+		}
+		owner = MutexTable[owner->waitMutex].owner;
+	}
+}
+
+/*
+	Drops proc to the best of its base priority and the priorities of the
+	waiters on the inheriting mutexes it still owns
+*/
+void restorePriority(procPtr proc) {
+	int priority = proc->basePriority;
+	for (mutexStruct *mutex = proc->heldMutexes; mutex != NULL; mutex = mutex->heldNext) {
+		if (mutex->flags & MUTEX_PRIO_INHERIT) {
+			for (procPtr waiter = mutex->waiters.head; waiter != NULL; waiter = waiter->waitNext) {
+				if (waiter->priority < priority) {
+					priority = waiter->priority;
+				}
+			}
+		}
+	}
+	setPriority(proc, priority);
+}
+
+/* ------------------------------------------------------------------------
+	 Name - readtime
+	 Purpose - Returns the kernel time as of the last clock interrupt or
+						 dispatch, without touching the clock device.
+	 Parameters - none
+	 Returns - the cached time in microseconds
+	 Side Effects - none
+	 ----------------------------------------------------------------------- */
+int readtime(void) {
+	return (int) kernelTime;
+}
+
+/* ------------------------------------------------------------------------
+	 Name - readtimePrecise
+	 Purpose - Reads the clock device and brings the kernel time up to date.
+	 Parameters - none
+	 Returns - the current time in microseconds, as 64 bits so it never wraps
+	 Side Effects - refreshes the time readtime() returns
+	 ----------------------------------------------------------------------- */
+long long readtimePrecise(void) {
+	return refreshKernelTime();
+}
+
+/*
+	Reads the clock device once and adds the time since the last reading
+	to kernelTime.  The device counter is only 32 bits, so the difference
+	is taken unsigned to carry across it wrapping around.
+*/
+static long long refreshKernelTime(void) {
+	int status = 0;
+	int dev_status = USLOSS_DeviceInput(USLOSS_CLOCK_DEV, 0, &status);//
+
+	if (dev_status != USLOSS_DEV_OK) {
 		USLOSS_Console("Failed to read current time. Halting...\n");
 		USLOSS_Halt(1);
-		return -1; //so it compiles without warning
 	}
+	kernelTime += (unsigned int) status - lastClockReading;
+	lastClockReading = (unsigned int) status;
+	return kernelTime;
 }
 
 void clockHandler(int dev, void *arg) {
 	if (DEBUG && debugflag)
 		USLOSS_Console("clockHandler(): clock interrupt occurred");
-	timeSlice();
+
+	// tickless idle: count off ticks without reading the clock until the
+	// next timer is due, then catch up all at once
+	int wasIdle = idleUntil != -1;
+	if (wasIdle) {
+		idleClock += CLOCKTICK;
+		if (idleClock < idleUntil) {
+			return;
+		}
+		idleUntil = -1;
+	}
+
+	refreshKernelTime();
+	timeFromTick = 1;
+	advanceTimers();
+	// the sentinel's slice has long run out, but whoever woke must run now
+	if (wasIdle) {
+		dispatcher();
+	}
+	else {
+		timeSlice();
+	}
+	timeFromTick = 0;
+}
+
+/*
+	Arms proc's timer to fire at the given time.  Timers live on a
+	hierarchical wheel: level 0 has one slot per clock tick, and each
+	higher level has one slot per full turn of the level below, so
+	inserting, cancelling and expiring a timer are all O(1).
+*/
+void armTimer(procPtr proc, long long deadline) {
+	// an empty wheel is not advanced, so catch it up first
+	if (numTimers == 0) {
+		currentTick = kernelTime / CLOCKTICK;
+	}
+	proc->wakeTime = deadline;
+	proc->timedOut = 0;
+	insertTimer(proc, currentTick + 1);
+	numTimers++;
+}
+
+/*
+	Disarms proc's timer if it has one
+*/
+void cancelTimer(procPtr proc) {
+	if (proc->wakeTime == -1) {
+		return;
+	}
+	if (proc->timerPrev == NULL) {
+		TimerWheel[proc->timerSlot / WHEELSLOTS][proc->timerSlot % WHEELSLOTS] = proc->timerNext;
+	}
+	else {
+		proc->timerPrev->timerNext = proc->timerNext;
+	}
+	if (proc->timerNext != NULL) {
+		proc->timerNext->timerPrev = proc->timerPrev;
+	}
+	proc->timerNext = NULL;
+	proc->timerPrev = NULL;
+	proc->wakeTime = -1;
+	numTimers--;
+}
+
+/*
+	Links proc into the wheel slot for its wakeTime, but no earlier than
+	the given tick
+*/
+static void insertTimer(procPtr proc, int earliest) {
+	int expires = (proc->wakeTime + CLOCKTICK - 1) / CLOCKTICK;
+	if (expires < earliest) {
+		expires = earliest;
+	}
+	int delta = expires - currentTick;
+	int level;
+	if (delta >= WHEELSLOTS * WHEELSLOTS * WHEELSLOTS) {
+		expires = currentTick + WHEELSLOTS * WHEELSLOTS * WHEELSLOTS - 1;
+	}
+	if (delta < WHEELSLOTS) {
+		level = 0;
+	}
+	else if (delta < WHEELSLOTS * WHEELSLOTS) {
+		level = 1;
+		expires /= WHEELSLOTS;
+	}
+	else {
+		level = 2;
+		expires /= WHEELSLOTS * WHEELSLOTS;
+	}
+
+	int slot = expires % WHEELSLOTS;
+	proc->timerSlot = level * WHEELSLOTS + slot;
+	proc->timerPrev = NULL;
+	proc->timerNext = TimerWheel[level][slot];
+	if (proc->timerNext != NULL) {
+		proc->timerNext->timerPrev = proc;
+	}
+	TimerWheel[level][slot] = proc;
+}
+
+/*
+	Moves every timer of a higher level slot down to where it now belongs
+*/
+static void cascadeTimers(int level, int slot) {
+	procPtr proc = TimerWheel[level][slot];
+	TimerWheel[level][slot] = NULL;
+	while (proc != NULL) {
+		procPtr next = proc->timerNext;
+		insertTimer(proc, currentTick);
+		proc = next;
+	}
+}
+
+/*
+	Advances the wheel to the current time, waking every process whose
+	timer has fired.  Costs O(1) per elapsed tick plus O(expired).
+*/
+static void advanceTimers(void) {
+	int nowTick = kernelTime / CLOCKTICK;
+
+	if (numTimers == 0) {
+		currentTick = nowTick;
+		return;
+	}
+
+	while (currentTick < nowTick) {
+		currentTick++;
+		int slot = currentTick % WHEELSLOTS;
+		if (slot == 0) {
+			int slot1 = (currentTick / WHEELSLOTS) % WHEELSLOTS;
+			if (slot1 == 0) {
+				cascadeTimers(2, (currentTick / (WHEELSLOTS * WHEELSLOTS)) % WHEELSLOTS);
+			}
+			cascadeTimers(1, slot1);
+		}
+
+		procPtr proc = TimerWheel[0][slot];
+		TimerWheel[0][slot] = NULL;
+		while (proc != NULL) {
+			procPtr next = proc->timerNext;
+			proc->timerNext = NULL;
+			proc->timerPrev = NULL;
+			proc->wakeTime = -1;
+			numTimers--;
+			// it may have been woken some other way and not run yet
+			if (proc->status != READY && proc->status != RUNNING) {
+				if (DEBUG && debugflag)
+					USLOSS_Console("advanceTimers(): timed wait of %d expired\n", proc->pid);
+				proc->timedOut = 1;
+				trace(TRACE_TIMEOUT, proc->pid, 0);
+				makeReady(proc);
+			}
+			proc = next;
+		}
+	}
+}
+
+/*
+	Returns the time of the next tick at which the wheel has work: the
+	first occupied level 0 slot, or the end of the current turn, where the
+	higher levels cascade.  IDLEFOREVER if no timer is armed.
+*/
+static long long nextTimerDeadline(void) {
+	if (numTimers == 0) {
+		return IDLEFOREVER;
+	}
+	int tick = currentTick + 1;
+	while (tick % WHEELSLOTS != 0 && TimerWheel[0][tick % WHEELSLOTS] == NULL) {
+		tick++;
+	}
+	return (long long) tick * CLOCKTICK;
 }
 
 void illegalInstructionHandler(int dev, void *arg) {
@@ -1005,30 +3464,23 @@ void illegalInstructionHandler(int dev, void *arg) {
 }
 
 void timeSlice(void){
-	int curTime = readtime();
-	int startTime = readCurStartTime();
-	if (curTime - startTime < 80000){
+	int cpuTime = (int) (kernelTime - Current->startTime);
+	if (cpuTime < 80000){
 		if (DEBUG && debugflag)
-			USLOSS_Console("timeSlice(): Process %d exceeded time slice with cpu time %d\n, calling dispatcher", Current->pid, curTime-startTime);
+			USLOSS_Console("timeSlice(): Process %d exceeded time slice with cpu time %d\n, calling dispatcher", Current->pid, cpuTime);
 		dispatcher();
 	} else {
 		if (DEBUG && debugflag)
-			USLOSS_Console("timeSlice(): Process %d did not exceed with cpu time %d\n", Current->pid, curTime-startTime);
+			USLOSS_Console("timeSlice(): Process %d did not exceed with cpu time %d\n", Current->pid, cpuTime);
 	}
 }
 
 int readCurStartTime(void){
-	return Current == NULL ? -1 : Current->startTime;
+	return Current == NULL ? -1 : (int) Current->startTime;
 }
 
 int countProcesses() {
-	int count = 0;
-	for (int i = 0; i < MAXPROC; i++) {
-		if (ProcTable[i].status != EMPTY && ProcTable[i].status != QUIT) {
-			count++;
-		}
-	}
-	return count;
+	return MAXPROC - StatusCounts[EMPTY] - StatusCounts[QUIT] - StatusCounts[DEAD];
 }
 
 int onReadyList(int pid, int priority){
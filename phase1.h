@@ -31,6 +31,136 @@
 
 #define MAXSYSCALLS  50
 
+/*
+ * Maximum number of kernel semaphores.
+ */
+
+#define MAXSEMAPHORES 100
+
+/*
+ * Maximum number of kernel mutexes and condition variables.
+ */
+
+#define MAXMUTEXES   100
+#define MAXCONDS     100
+
+/*
+ * Maximum number of message channels, and of messages one can hold.
+ */
+
+#define MAXCHANNELS  20
+#define MAXCHANSLOTS 64
+
+/*
+ * Maximum number of kernel barriers.
+ */
+
+#define MAXBARRIERS  20
+
+/*
+ * Flags for fork1Flags().
+ */
+
+#define FORK_DETACHED 0x1
+
+/*
+ * Events reported by waitEvent().
+ */
+
+#define WAIT_CHILD     1
+#define WAIT_UNBLOCKED 2
+#define WAIT_ZAPPED    3
+
+/*
+ * Modes for zapWait().
+ */
+
+#define ZAP_WAIT_ANY   1
+#define ZAP_WAIT_ALL   2
+
+/*
+ * Flags for mutexCreate().
+ */
+
+#define MUTEX_PRIO_INHERIT 0x1
+
+
+/*
+ * Scheduling statistics reported by getProcStats().  Times are in
+ * microseconds.
+ */
+
+typedef struct procStats {
+    int       pid;
+    long long cpuTime;             /* including the current run, if running */
+    long long readyTime;           /* ready but waiting for the CPU */
+    long long joinBlockedTime;
+    long long zapBlockedTime;
+    long long meBlockedTime;       /* blockMe() and sleepMe() */
+    long long syncBlockedTime;     /* waitEvent() and kernel sync objects */
+    int       dispatches;
+    int       voluntarySwitches;   /* gave up the CPU by blocking or quitting */
+    int       involuntarySwitches; /* preempted while still runnable */
+} procStats;
+
+/*
+ * Process statuses, as reported by snapshotProcesses() and the trace
+ * ring.  blockMe() statuses are above MEBLOCKED.
+ */
+
+#define EMPTY 0
+#define READY 1
+#define RUNNING 2
+#define JOINBLOCKED 3
+#define ZAPBLOCKED 4
+#define QUIT 5
+#define DEAD 6            /* joined or detached, slot not yet cleaned */
+#define WAITBLOCKED 7     /* blocked in waitEvent() */
+#define SYNCBLOCKED 8     /* blocked on a kernel sync object, address or channel */
+#define SLEEPBLOCKED 9    /* blocked in sleepMe() */
+#define MEBLOCKED 10
+
+/*
+ * One process as copied by snapshotProcesses().
+ */
+
+typedef struct procSnapshot {
+    int       pid;
+    int       parentPid;           /* -1 if none */
+    int       priority;
+    int       status;
+    int       numLiveKids;
+    int       numJoins;
+    int       zapped;
+    long long cpuTime;
+    char      name[MAXNAME];
+} procSnapshot;
+
+/*
+ * Kernel trace ring: the last TRACESIZE scheduling events, kept all the
+ * time.  Read with readTrace(), or printed by dumpTrace() and, when
+ * traceflag is set, at halt.
+ */
+
+#define TRACESIZE      1024
+
+#define TRACE_FORK     1   /* arg: pid of the parent, -1 if none */
+#define TRACE_QUIT     2   /* arg: quit status */
+#define TRACE_SWITCH   3   /* pid: switched to, arg: from, -1 if it quit */
+#define TRACE_BLOCK    4   /* arg: status it blocked in */
+#define TRACE_WAKE     5   /* arg: status it was woken from */
+#define TRACE_ZAP      6   /* arg: pid being zapped */
+#define TRACE_TIMEOUT  7   /* a timed wait expired */
+
+typedef struct traceRecord {
+    long long time;                /* kernel time, as readtime() */
+    int       arg;
+    short     pid;
+    short     event;
+} traceRecord;
+
+extern int traceflag;
+
 
 /* 
  * Function prototypes for this phase.
@@ -38,18 +168,62 @@
 
 extern int   fork1(char *name, int(*func)(char *), char *arg,
                    int stacksize, int priority);
+extern int   fork1Flags(char *name, int(*func)(char *), char *arg,
+                   int stacksize, int priority, int flags);
 extern int   join(int *status);
+extern int   tryJoin(int *status);
+extern int   joinTimeout(int *status, int timeout);
+extern int   joinAll(int pids[], int statuses[], int max);
+extern int   waitEvent(int *pid, int *status);
 extern void  quit(int status);
 extern int   zap(int pid);
+extern int   zapAsync(int pid);
+extern int   zapWait(int mode);
+extern int   zapTree(int pid);
 extern int   isZapped(void);
 extern int   getpid(void);
 extern void  dumpProcesses(void);
+extern void  dumpStatusCounts(void);
 extern int   blockMe(int block_status);
+extern int   blockMeTimeout(int block_status, int timeout);
+extern int   sleepMe(int usec);
 extern int   unblockProc(int pid);
+extern int   semCreate(int value);
+extern int   semP(int id);
+extern int   semV(int id);
+extern int   semFree(int id);
+extern int   mutexCreate(int flags);
+extern int   mutexLock(int id);
+extern int   mutexUnlock(int id);
+extern int   mutexFree(int id);
+extern int   condCreate(void);
+extern int   condWait(int cond, int mutex);
+extern int   condSignal(int cond);
+extern int   condBroadcast(int cond);
+extern int   condFree(int cond);
+extern int   blockOn(int *addr, int expected);
+extern int   wakeAddr(int *addr, int n);
+extern int   barrierCreate(int n);
+extern int   barrierWait(int id);
+extern int   barrierFree(int id);
+extern int   chanCreate(int capacity);
+extern int   chanSend(int id, int msg);
+extern int   chanSendMany(int id, int msgs[], int n);
+extern int   chanReceive(int id, int *msg);
+extern int   chanReceiveMany(int id, int msgs[], int max);
+extern int   chanFree(int id);
+extern int   getProcStats(int pid, procStats *stats);
+extern void  getPsrOps(int *reads, int *writes);
+extern int   readTrace(traceRecord records[], int max);
+extern int   snapshotProcesses(procSnapshot procs[], int max);
+extern int   snapshotToCSV(procSnapshot procs[], int n, char *buf, int size);
+extern int   snapshotToJSON(procSnapshot procs[], int n, char *buf, int size);
+extern void  dumpTrace(void);
 extern int   readCurStartTime(void);
 extern void  timeSlice(void);
 extern void  dispatcher(void);
 extern int   readtime(void);
+extern long long readtimePrecise(void);
 
 extern void  p1_fork(int pid);
 extern void  p1_quit(int pid);
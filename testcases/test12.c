@@ -1,7 +1,7 @@
 /* this test case checks for deadlocks: 
       start1 forks XXp1 and is blocked on the join of XXp1 
       XXp1 then runs and zaps start1.
-   This will result in deadlock, which USLOSS should report.
+   This would result in deadlock, so zap() returns -3 instead of blocking.
  */
 
 #include <stdio.h>
@@ -0,0 +1,60 @@
+/* Tests tryJoin() and joinTimeout().
+ *
+ * start1 creates XXp1 at priority 3, which blocks itself.
+ * start1 tries a non-blocking join, which must fail with -3 since
+ * XXp1 has not quit, then a timed join, which must time out with -3.
+ * start1 then unblocks XXp1 and joins it normally.
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+int XXp1(char *);
+char buf[256];
+int pid1;
+
+void test_setup(int argc, char *argv[])
+{
+}
+
+void test_cleanup(int argc, char *argv[])
+{
+}
+
+int start1(char *arg)
+{
+    int status, kidpid, result;
+
+    USLOSS_Console("start1(): started\n");
+    pid1 = fork1("XXp1", XXp1, "XXp1", USLOSS_MIN_STACK, 3);
+    USLOSS_Console("start1(): after fork of child %d\n", pid1);
+
+    kidpid = tryJoin(&status);
+    USLOSS_Console("start1(): tryJoin returned %d\n", kidpid);
+
+    kidpid = joinTimeout(&status, 50000);
+    USLOSS_Console("start1(): joinTimeout returned %d\n", kidpid);
+
+    result = unblockProc(pid1);
+    USLOSS_Console("start1(): unblockProc returned %d\n", result);
+
+    kidpid = join(&status);
+    sprintf(buf,"start1(): exit status for child %d is %d\n", kidpid, status); 
+    USLOSS_Console("%s", buf);
+
+    kidpid = tryJoin(&status);
+    USLOSS_Console("start1(): tryJoin with no children returned %d\n", kidpid);
+    return 0;
+}
+
+int XXp1(char *arg)
+{
+    int result;
+
+    USLOSS_Console("XXp1(): started\n");
+    result = blockMe(11);
+    USLOSS_Console("XXp1(): blockMe returned %d\n", result);
+    quit(5);
+    return 0;
+}
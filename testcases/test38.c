@@ -0,0 +1,66 @@
+/* Tests detached processes.
+ *
+ * start1 creates XXp1 at priority 2.  XXp1 creates 60 detached children
+ * at priority 1, more than fit in the process table at once.  Each one
+ * quits right away and its slot is reclaimed without a join, so every
+ * fork succeeds and XXp1 has no children left to join.  Unknown flags
+ * are rejected with -1.
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+#define NUMDETACHED 60
+
+int XXp1(char *), XXp2(char *);
+char buf[256];
+int ran = 0;
+
+void test_setup(int argc, char *argv[])
+{
+}
+
+void test_cleanup(int argc, char *argv[])
+{
+}
+
+int start1(char *arg)
+{
+    int status, pid1, kidpid;
+
+    USLOSS_Console("start1(): started\n");
+    pid1 = fork1("XXp1", XXp1, "XXp1", USLOSS_MIN_STACK, 2);
+    USLOSS_Console("start1(): after fork of child %d\n", pid1);
+    kidpid = join(&status);
+    sprintf(buf,"start1(): exit status for child %d is %d\n", kidpid, status); 
+    USLOSS_Console("%s", buf);
+    return 0;
+}
+
+int XXp1(char *arg)
+{
+    int i, failed = 0, status, kidpid;
+
+    USLOSS_Console("XXp1(): started\n");
+    for (i = 0; i < NUMDETACHED; i++) {
+        if (fork1Flags("XXp2", XXp2, NULL, USLOSS_MIN_STACK, 1,
+                       FORK_DETACHED) < 0)
+            failed++;
+    }
+    USLOSS_Console("XXp1(): %d detached children ran, %d forks failed\n",
+                   ran, failed);
+    USLOSS_Console("XXp1(): fork1Flags with unknown flags returned %d\n",
+                   fork1Flags("XXp2", XXp2, NULL, USLOSS_MIN_STACK, 1, 0x4));
+    kidpid = join(&status);
+    USLOSS_Console("XXp1(): join returned %d\n", kidpid);
+    quit(-3);
+    return 0;
+}
+
+int XXp2(char *arg)
+{
+    ran++;
+    quit(1);
+    return 0;
+}
@@ -0,0 +1,61 @@
+/* Tests joinAll().
+ *
+ * start1 creates three children at priority 3, then calls joinAll()
+ * with room for only two statuses.  joinAll() returns once all three
+ * have quit, with the first two; a plain join() collects the third.
+ * A NULL array or a negative max is rejected with -2 first.
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+int XXp1(char *);
+char buf[256];
+
+void test_setup(int argc, char *argv[])
+{
+}
+
+void test_cleanup(int argc, char *argv[])
+{
+}
+
+int start1(char *arg)
+{
+    int i, count, status, kidpid;
+    int pids[2], statuses[2];
+
+    USLOSS_Console("start1(): started\n");
+    for (i = 0; i < 3; i++) {
+        kidpid = fork1("XXp1", XXp1, "XXp1", USLOSS_MIN_STACK, 3);
+        USLOSS_Console("start1(): after fork of child %d\n", kidpid);
+    }
+
+    USLOSS_Console("start1(): joinAll with NULL pids returned %d\n",
+                   joinAll(NULL, statuses, 2));
+    USLOSS_Console("start1(): joinAll with max -1 returned %d\n",
+                   joinAll(pids, statuses, -1));
+
+    count = joinAll(pids, statuses, 2);
+    USLOSS_Console("start1(): joinAll returned %d\n", count);
+    for (i = 0; i < count; i++) {
+        sprintf(buf,"start1(): exit status for child %d is %d\n", pids[i], statuses[i]); 
+        USLOSS_Console("%s", buf);
+    }
+
+    kidpid = join(&status);
+    sprintf(buf,"start1(): exit status for child %d is %d\n", kidpid, status); 
+    USLOSS_Console("%s", buf);
+
+    count = joinAll(pids, statuses, 2);
+    USLOSS_Console("start1(): joinAll with no children returned %d\n", count);
+    return 0;
+}
+
+int XXp1(char *arg)
+{
+    USLOSS_Console("XXp1(): started, pid = %d\n", getpid());
+    quit(-getpid());
+    return 0;
+}
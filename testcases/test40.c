@@ -0,0 +1,87 @@
+/* Tests waitEvent().
+ *
+ * start1 creates XXp1 at priority 2 and waits for an event.  XXp1 calls
+ * unblockProc() on start1, so the first wait reports WAIT_UNBLOCKED.
+ * start1 waits again and XXp1 quits, so the second reports WAIT_CHILD.
+ *
+ * start1 then creates XXp2 at priority 3 and XXp3 at priority 4.  XXp2
+ * waits for an event and is zapped by XXp3, so it sees WAIT_ZAPPED.
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+int XXp1(char *), XXp2(char *), XXp3(char *);
+char buf[256];
+int pid2;
+
+void test_setup(int argc, char *argv[])
+{
+}
+
+void test_cleanup(int argc, char *argv[])
+{
+}
+
+int start1(char *arg)
+{
+    int status, pid1, kidpid, event;
+
+    USLOSS_Console("start1(): started\n");
+    pid1 = fork1("XXp1", XXp1, "XXp1", USLOSS_MIN_STACK, 2);
+    USLOSS_Console("start1(): after fork of child %d\n", pid1);
+
+    event = waitEvent(&kidpid, &status);
+    USLOSS_Console("start1(): first waitEvent returned %d\n", event);
+    event = waitEvent(&kidpid, &status);
+    USLOSS_Console("start1(): second waitEvent returned %d\n", event);
+    sprintf(buf,"start1(): exit status for child %d is %d\n", kidpid, status); 
+    USLOSS_Console("%s", buf);
+
+    pid2 = fork1("XXp2", XXp2, "XXp2", USLOSS_MIN_STACK, 3);
+    USLOSS_Console("start1(): after fork of child %d\n", pid2);
+    kidpid = fork1("XXp3", XXp3, "XXp3", USLOSS_MIN_STACK, 4);
+    USLOSS_Console("start1(): after fork of child %d\n", kidpid);
+
+    kidpid = join(&status);
+    sprintf(buf,"start1(): exit status for child %d is %d\n", kidpid, status); 
+    USLOSS_Console("%s", buf);
+    kidpid = join(&status);
+    sprintf(buf,"start1(): exit status for child %d is %d\n", kidpid, status); 
+    USLOSS_Console("%s", buf);
+    return 0;
+}
+
+int XXp1(char *arg)
+{
+    int result;
+
+    USLOSS_Console("XXp1(): started\n");
+    result = unblockProc(2);
+    USLOSS_Console("XXp1(): unblockProc(2) returned %d\n", result);
+    quit(-3);
+    return 0;
+}
+
+int XXp2(char *arg)
+{
+    int event, kidpid, status;
+
+    USLOSS_Console("XXp2(): started\n");
+    event = waitEvent(&kidpid, &status);
+    USLOSS_Console("XXp2(): waitEvent returned %d\n", event);
+    quit(-4);
+    return 0;
+}
+
+int XXp3(char *arg)
+{
+    int result;
+
+    USLOSS_Console("XXp3(): started\n");
+    result = zap(pid2);
+    USLOSS_Console("XXp3(): zap(%d) returned %d\n", pid2, result);
+    quit(-5);
+    return 0;
+}
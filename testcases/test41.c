@@ -0,0 +1,65 @@
+/* Tests zapAsync() and zapWait().
+ *
+ * start1 creates three workers at priority 3 that wait in waitEvent()
+ * until they are zapped.  It zaps all three with zapAsync(), checks that
+ * an invalid mode is rejected, and waits once with ZAP_WAIT_ALL.  It then zaps two more workers and collects
+ * them one at a time with ZAP_WAIT_ANY.
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+int Worker(char *);
+char buf[256];
+
+void test_setup(int argc, char *argv[])
+{
+}
+
+void test_cleanup(int argc, char *argv[])
+{
+}
+
+int start1(char *arg)
+{
+    int i, status, kidpid, result;
+    int pids[3];
+
+    USLOSS_Console("start1(): started\n");
+    for (i = 0; i < 3; i++)
+        pids[i] = fork1("Worker", Worker, NULL, USLOSS_MIN_STACK, 3);
+    for (i = 0; i < 3; i++)
+        USLOSS_Console("start1(): zapAsync(%d) returned %d\n", pids[i], zapAsync(pids[i]));
+    USLOSS_Console("start1(): zapWait(0) returned %d\n", zapWait(0));
+    result = zapWait(ZAP_WAIT_ALL);
+    USLOSS_Console("start1(): zapWait(ZAP_WAIT_ALL) returned %d\n", result);
+
+    for (i = 0; i < 2; i++) {
+        pids[i] = fork1("Worker", Worker, NULL, USLOSS_MIN_STACK, 3);
+        zapAsync(pids[i]);
+    }
+    for (i = 0; i < 3; i++) {
+        result = zapWait(ZAP_WAIT_ANY);
+        USLOSS_Console("start1(): zapWait(ZAP_WAIT_ANY) returned %d\n", result);
+    }
+
+    for (i = 0; i < 5; i++) {
+        kidpid = join(&status);
+        sprintf(buf,"start1(): exit status for child %d is %d\n", kidpid, status); 
+        USLOSS_Console("%s", buf);
+    }
+    return 0;
+}
+
+int Worker(char *arg)
+{
+    int kidpid, status;
+
+    USLOSS_Console("Worker(): %d started\n", getpid());
+    if (!isZapped())
+        waitEvent(&kidpid, &status);
+    USLOSS_Console("Worker(): %d quitting, zapped = %d\n", getpid(), isZapped());
+    quit(-getpid());
+    return 0;
+}
@@ -0,0 +1,103 @@
+/* Tests zapTree().
+ *
+ * start1 creates Pool at priority 2 and Killer at priority 5.  Pool
+ * creates two workers at priority 3 and joins them.  Worker W1 blocks
+ * itself; worker W2 creates a grandchild G at priority 4, which blocks
+ * itself, and joins it.
+ *
+ * Once everything else is blocked, Killer calls zapTree() on Pool.
+ * Every process in the tree wakes up zapped and quits, children before
+ * parents: a parent in join() wakes to collect the child that quit.
+ * Killer's zapTree() returns only after Pool has quit.
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+int Pool(char *), W1(char *), W2(char *), G(char *), Killer(char *);
+char buf[256];
+int poolPid;
+
+void test_setup(int argc, char *argv[])
+{
+}
+
+void test_cleanup(int argc, char *argv[])
+{
+}
+
+int joinKid(char *name)
+{
+    int status = 0, kidpid;
+
+    kidpid = join(&status);
+    USLOSS_Console("%s(): join returned %d, status %d\n", name, kidpid, status);
+    return kidpid;
+}
+
+int start1(char *arg)
+{
+    int kidpid;
+
+    USLOSS_Console("start1(): started\n");
+    poolPid = fork1("Pool", Pool, NULL, USLOSS_MIN_STACK, 2);
+    kidpid = fork1("Killer", Killer, NULL, USLOSS_MIN_STACK, 5);
+    USLOSS_Console("start1(): after fork of children %d and %d\n", poolPid, kidpid);
+    joinKid("start1");
+    joinKid("start1");
+    return 0;
+}
+
+int Pool(char *arg)
+{
+    USLOSS_Console("Pool(): started\n");
+    fork1("W1", W1, NULL, USLOSS_MIN_STACK, 3);
+    fork1("W2", W2, NULL, USLOSS_MIN_STACK, 3);
+    joinKid("Pool");
+    joinKid("Pool");
+    quit(-2);
+    return 0;
+}
+
+int W1(char *arg)
+{
+    int result;
+
+    USLOSS_Console("W1(): started\n");
+    result = blockMe(20);
+    USLOSS_Console("W1(): blockMe returned %d\n", result);
+    quit(-3);
+    return 0;
+}
+
+int W2(char *arg)
+{
+    USLOSS_Console("W2(): started\n");
+    fork1("G", G, NULL, USLOSS_MIN_STACK, 4);
+    joinKid("W2");
+    quit(-4);
+    return 0;
+}
+
+int G(char *arg)
+{
+    int result;
+
+    USLOSS_Console("G(): started\n");
+    result = blockMe(20);
+    USLOSS_Console("G(): blockMe returned %d\n", result);
+    quit(-5);
+    return 0;
+}
+
+int Killer(char *arg)
+{
+    int result;
+
+    USLOSS_Console("Killer(): started, calling zapTree(%d)\n", poolPid);
+    result = zapTree(poolPid);
+    USLOSS_Console("Killer(): zapTree returned %d\n", result);
+    quit(-6);
+    return 0;
+}
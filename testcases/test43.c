@@ -0,0 +1,78 @@
+/* Tests kernel semaphores.
+ *
+ * start1 creates a semaphore with value 0, a Consumer at priority 3 and
+ * a Producer at priority 4.  The Consumer does three semP()s, blocking
+ * each time; each semV() by the Producer wakes the higher-priority
+ * Consumer right away.
+ *
+ * The Consumer then waits on the semaphore again and start1 frees it,
+ * so that semP() returns -2.
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+int Consumer(char *), Producer(char *);
+char buf[256];
+int sem;
+
+void test_setup(int argc, char *argv[])
+{
+}
+
+void test_cleanup(int argc, char *argv[])
+{
+}
+
+int start1(char *arg)
+{
+    int status, kidpid, result;
+
+    USLOSS_Console("start1(): started\n");
+    USLOSS_Console("start1(): semP on bad id returned %d\n", semP(-1));
+    sem = semCreate(0);
+    USLOSS_Console("start1(): semCreate returned %d\n", sem);
+    fork1("Consumer", Consumer, NULL, USLOSS_MIN_STACK, 3);
+    fork1("Producer", Producer, NULL, USLOSS_MIN_STACK, 4);
+
+    kidpid = join(&status);
+    sprintf(buf,"start1(): exit status for child %d is %d\n", kidpid, status); 
+    USLOSS_Console("%s", buf);
+
+    result = semFree(sem);
+    USLOSS_Console("start1(): semFree returned %d\n", result);
+    kidpid = join(&status);
+    sprintf(buf,"start1(): exit status for child %d is %d\n", kidpid, status); 
+    USLOSS_Console("%s", buf);
+    return 0;
+}
+
+int Consumer(char *arg)
+{
+    int i, result;
+
+    for (i = 0; i < 3; i++) {
+        USLOSS_Console("Consumer(): calling semP\n");
+        result = semP(sem);
+        USLOSS_Console("Consumer(): semP returned %d\n", result);
+    }
+    USLOSS_Console("Consumer(): calling semP, start1 will free the semaphore\n");
+    result = semP(sem);
+    USLOSS_Console("Consumer(): semP returned %d\n", result);
+    quit(-3);
+    return 0;
+}
+
+int Producer(char *arg)
+{
+    int i;
+
+    for (i = 0; i < 3; i++) {
+        USLOSS_Console("Producer(): calling semV\n");
+        semV(sem);
+    }
+    USLOSS_Console("Producer(): done\n");
+    quit(-4);
+    return 0;
+}
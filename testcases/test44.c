@@ -0,0 +1,115 @@
+/* Tests kernel mutexes and condition variables.
+ *
+ * Priority inheritance: Low (priority 4) locks an inheriting mutex and
+ * creates High (priority 2), which blocks on it.  Low now runs at
+ * priority 2, so creating Med (priority 3) does not preempt it.  When
+ * Low unlocks, High gets the mutex and runs before Med.
+ *
+ * Condition variables: two Waiters (priority 2) wait on a condition for
+ * a count to become positive.  Setter (priority 3) sets it under the
+ * mutex and broadcasts.  The Waiters wake one at a time, as each gets
+ * the mutex in turn.
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+int Low(char *), Med(char *), High(char *), Waiter(char *), Setter(char *);
+char buf[256];
+int pim, mutex, cond, count = 0;
+
+void test_setup(int argc, char *argv[])
+{
+}
+
+void test_cleanup(int argc, char *argv[])
+{
+}
+
+int start1(char *arg)
+{
+    int i, status, kidpid;
+
+    USLOSS_Console("start1(): started\n");
+    pim = mutexCreate(MUTEX_PRIO_INHERIT);
+    fork1("Low", Low, NULL, USLOSS_MIN_STACK, 4);
+    kidpid = join(&status);
+    sprintf(buf,"start1(): exit status for child %d is %d\n", kidpid, status); 
+    USLOSS_Console("%s", buf);
+
+    mutex = mutexCreate(0);
+    cond = condCreate();
+    fork1("Waiter", Waiter, "A", USLOSS_MIN_STACK, 2);
+    fork1("Waiter", Waiter, "B", USLOSS_MIN_STACK, 2);
+    fork1("Setter", Setter, NULL, USLOSS_MIN_STACK, 3);
+    for (i = 0; i < 3; i++) {
+        kidpid = join(&status);
+        sprintf(buf,"start1(): exit status for child %d is %d\n", kidpid, status); 
+        USLOSS_Console("%s", buf);
+    }
+
+    USLOSS_Console("start1(): mutexUnlock by non-owner returned %d\n", mutexUnlock(mutex));
+    USLOSS_Console("start1(): condFree returned %d\n", condFree(cond));
+    USLOSS_Console("start1(): mutexFree returned %d\n", mutexFree(mutex));
+    return 0;
+}
+
+int Low(char *arg)
+{
+    int status, i;
+
+    USLOSS_Console("Low(): locking, result %d\n", mutexLock(pim));
+    fork1("High", High, NULL, USLOSS_MIN_STACK, 2);
+    USLOSS_Console("Low(): after fork of High\n");
+    fork1("Med", Med, NULL, USLOSS_MIN_STACK, 3);
+    USLOSS_Console("Low(): after fork of Med, unlocking\n");
+    mutexUnlock(pim);
+    USLOSS_Console("Low(): after unlock\n");
+    for (i = 0; i < 2; i++)
+        join(&status);
+    quit(-4);
+    return 0;
+}
+
+int Med(char *arg)
+{
+    USLOSS_Console("Med(): started\n");
+    quit(-3);
+    return 0;
+}
+
+int High(char *arg)
+{
+    USLOSS_Console("High(): locking\n");
+    USLOSS_Console("High(): mutexLock returned %d\n", mutexLock(pim));
+    mutexUnlock(pim);
+    quit(-2);
+    return 0;
+}
+
+int Waiter(char *arg)
+{
+    mutexLock(mutex);
+    while (count == 0) {
+        USLOSS_Console("Waiter(): %s waiting\n", arg);
+        condWait(cond, mutex);
+        USLOSS_Console("Waiter(): %s woke with the mutex, count = %d\n", arg, count);
+    }
+    count--;
+    mutexUnlock(mutex);
+    quit(-5);
+    return 0;
+}
+
+int Setter(char *arg)
+{
+    mutexLock(mutex);
+    count = 2;
+    USLOSS_Console("Setter(): broadcasting\n");
+    condBroadcast(cond);
+    USLOSS_Console("Setter(): unlocking\n");
+    mutexUnlock(mutex);
+    quit(-6);
+    return 0;
+}
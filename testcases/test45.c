@@ -0,0 +1,63 @@
+/* Tests blockOn() and wakeAddr().
+ *
+ * start1 calls blockOn() with a stale expected value, which returns -3
+ * without blocking.  Three Waiters at priority 3 block on flag while it
+ * is 0.  Waker (priority 4) sets flag, wakes two of them, then the rest.
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+int Waiter(char *), Waker(char *);
+char buf[256];
+int flag = 0;
+int other = 0;
+
+void test_setup(int argc, char *argv[])
+{
+}
+
+void test_cleanup(int argc, char *argv[])
+{
+}
+
+int start1(char *arg)
+{
+    int i, status, kidpid;
+
+    USLOSS_Console("start1(): started\n");
+    USLOSS_Console("start1(): blockOn(&flag, 1) returned %d\n", blockOn(&flag, 1));
+    fork1("Waiter", Waiter, "A", USLOSS_MIN_STACK, 3);
+    fork1("Waiter", Waiter, "B", USLOSS_MIN_STACK, 3);
+    fork1("Waiter", Waiter, "C", USLOSS_MIN_STACK, 3);
+    fork1("Waker", Waker, NULL, USLOSS_MIN_STACK, 4);
+    for (i = 0; i < 4; i++) {
+        kidpid = join(&status);
+        sprintf(buf,"start1(): exit status for child %d is %d\n", kidpid, status); 
+        USLOSS_Console("%s", buf);
+    }
+    return 0;
+}
+
+int Waiter(char *arg)
+{
+    int result;
+
+    USLOSS_Console("Waiter(): %s blocking on flag\n", arg);
+    result = blockOn(&flag, 0);
+    USLOSS_Console("Waiter(): %s woke, result %d, flag = %d\n", arg, result, flag);
+    quit(-3);
+    return 0;
+}
+
+int Waker(char *arg)
+{
+    USLOSS_Console("Waker(): waking on an address nobody waits on: %d\n", wakeAddr(&other, 5));
+    flag = 1;
+    USLOSS_Console("Waker(): waking two\n");
+    USLOSS_Console("Waker(): wakeAddr(&flag, 2) returned %d\n", wakeAddr(&flag, 2));
+    USLOSS_Console("Waker(): wakeAddr(&flag, 10) returned %d\n", wakeAddr(&flag, 10));
+    quit(-4);
+    return 0;
+}
@@ -0,0 +1,77 @@
+/* Tests message channels.
+ *
+ * start1 creates a channel holding 4 messages, a Consumer at priority 3
+ * and a Producer at priority 4.  The Consumer receives up to 3 messages
+ * at a time until it gets -1.  The Producer sends 10 messages with one
+ * chanSendMany(), which hands the first 3 to the waiting Consumer,
+ * queues 4 and blocks until the Consumer has made room for the rest.
+ * It then sends -1 with chanSend().
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+int Consumer(char *), Producer(char *);
+char buf[256];
+int chan;
+
+void test_setup(int argc, char *argv[])
+{
+}
+
+void test_cleanup(int argc, char *argv[])
+{
+}
+
+int start1(char *arg)
+{
+    int i, status, kidpid;
+
+    USLOSS_Console("start1(): started\n");
+    USLOSS_Console("start1(): chanCreate(0) returned %d\n", chanCreate(0));
+    chan = chanCreate(4);
+    USLOSS_Console("start1(): chanCreate(4) returned %d\n", chan);
+    fork1("Consumer", Consumer, NULL, USLOSS_MIN_STACK, 3);
+    fork1("Producer", Producer, NULL, USLOSS_MIN_STACK, 4);
+    for (i = 0; i < 2; i++) {
+        kidpid = join(&status);
+        sprintf(buf,"start1(): exit status for child %d is %d\n", kidpid, status); 
+        USLOSS_Console("%s", buf);
+    }
+    USLOSS_Console("start1(): chanFree returned %d\n", chanFree(chan));
+    USLOSS_Console("start1(): chanSend on freed channel returned %d\n", chanSend(chan, 1));
+    return 0;
+}
+
+int Consumer(char *arg)
+{
+    int msgs[3], i, n;
+
+    while (1) {
+        n = chanReceiveMany(chan, msgs, 3);
+        USLOSS_Console("Consumer(): received %d:", n);
+        for (i = 0; i < n; i++)
+            USLOSS_Console(" %d", msgs[i]);
+        USLOSS_Console("\n");
+        if (msgs[n - 1] == -1)
+            break;
+    }
+    quit(-3);
+    return 0;
+}
+
+int Producer(char *arg)
+{
+    int msgs[10], i, result;
+
+    for (i = 0; i < 10; i++)
+        msgs[i] = i + 1;
+    USLOSS_Console("Producer(): sending 10 messages\n");
+    result = chanSendMany(chan, msgs, 10);
+    USLOSS_Console("Producer(): chanSendMany returned %d\n", result);
+    result = chanSend(chan, -1);
+    USLOSS_Console("Producer(): chanSend returned %d\n", result);
+    quit(-4);
+    return 0;
+}
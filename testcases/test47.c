@@ -0,0 +1,55 @@
+/* Tests barriers.
+ *
+ * start1 creates a barrier for 3 processes and three Workers at
+ * priorities 2, 3 and 4.  Each Worker runs 2 steps and waits at the
+ * barrier after each one.  No Worker starts a step until all three have
+ * finished the previous one.  The Worker that arrives last reports 1.
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+int Worker(char *);
+char buf[256];
+int barrier;
+
+void test_setup(int argc, char *argv[])
+{
+}
+
+void test_cleanup(int argc, char *argv[])
+{
+}
+
+int start1(char *arg)
+{
+    int i, status, kidpid;
+
+    USLOSS_Console("start1(): started\n");
+    barrier = barrierCreate(3);
+    fork1("Worker", Worker, "A", USLOSS_MIN_STACK, 2);
+    fork1("Worker", Worker, "B", USLOSS_MIN_STACK, 3);
+    fork1("Worker", Worker, "C", USLOSS_MIN_STACK, 4);
+    for (i = 0; i < 3; i++) {
+        kidpid = join(&status);
+        sprintf(buf,"start1(): exit status for child %d is %d\n", kidpid, status); 
+        USLOSS_Console("%s", buf);
+    }
+    USLOSS_Console("start1(): barrierFree returned %d\n", barrierFree(barrier));
+    USLOSS_Console("start1(): barrierWait on freed barrier returned %d\n", barrierWait(barrier));
+    return 0;
+}
+
+int Worker(char *arg)
+{
+    int step, result;
+
+    for (step = 1; step <= 2; step++) {
+        USLOSS_Console("Worker(): %s finished step %d\n", arg, step);
+        result = barrierWait(barrier);
+        USLOSS_Console("Worker(): %s passed barrier %d, result %d\n", arg, step, result);
+    }
+    quit(-3);
+    return 0;
+}
@@ -0,0 +1,73 @@
+/* Tests blockMeTimeout().
+ *
+ * start1 creates three children at priority 3, which all block with a
+ * timeout.  XXp1's short timeout expires first and it unblocks XXp3, so
+ * XXp3 returns 0 long before its own timeout.  XXp2's timeout is longer
+ * than one turn of the timer wheel's first level and expires last.
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+int XXp1(char *), XXp2(char *), XXp3(char *);
+char buf[256];
+int pid3;
+
+void test_setup(int argc, char *argv[])
+{
+}
+
+void test_cleanup(int argc, char *argv[])
+{
+}
+
+int start1(char *arg)
+{
+    int i, status, kidpid;
+
+    USLOSS_Console("start1(): started\n");
+    fork1("XXp1", XXp1, NULL, USLOSS_MIN_STACK, 3);
+    fork1("XXp2", XXp2, NULL, USLOSS_MIN_STACK, 3);
+    pid3 = fork1("XXp3", XXp3, NULL, USLOSS_MIN_STACK, 3);
+    for (i = 0; i < 3; i++) {
+        kidpid = join(&status);
+        sprintf(buf,"start1(): exit status for child %d is %d\n", kidpid, status); 
+        USLOSS_Console("%s", buf);
+    }
+    return 0;
+}
+
+int timedBlock(char *name, int status, int timeout)
+{
+    int start, result;
+
+    USLOSS_Console("%s(): blocking for up to %d usec\n", name, timeout);
+    start = readtime();
+    result = blockMeTimeout(status, timeout);
+    USLOSS_Console("%s(): blockMeTimeout returned %d, timeout passed = %d\n",
+                   name, result, readtime() - start >= timeout);
+    return result;
+}
+
+int XXp1(char *arg)
+{
+    timedBlock("XXp1", 11, 100000);
+    USLOSS_Console("XXp1(): unblockProc(%d) returned %d\n", pid3, unblockProc(pid3));
+    quit(-3);
+    return 0;
+}
+
+int XXp2(char *arg)
+{
+    timedBlock("XXp2", 12, 2000000);
+    quit(-4);
+    return 0;
+}
+
+int XXp3(char *arg)
+{
+    timedBlock("XXp3", 13, 5000000);
+    quit(-5);
+    return 0;
+}
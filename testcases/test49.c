@@ -0,0 +1,53 @@
+/* Tests sleepMe().
+ *
+ * start1 creates three Sleepers at priority 3, which sleep for 300, 100
+ * and 200 milliseconds.  They wake in order of their deadlines, not
+ * the order they went to sleep in, and each sleeps at least as long
+ * as it asked to.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <usloss.h>
+#include <phase1.h>
+
+int Sleeper(char *);
+char buf[256];
+
+void test_setup(int argc, char *argv[])
+{
+}
+
+void test_cleanup(int argc, char *argv[])
+{
+}
+
+int start1(char *arg)
+{
+    int i, status, kidpid;
+
+    USLOSS_Console("start1(): started\n");
+    USLOSS_Console("start1(): sleepMe(0) returned %d\n", sleepMe(0));
+    fork1("Sleeper", Sleeper, "300000", USLOSS_MIN_STACK, 3);
+    fork1("Sleeper", Sleeper, "100000", USLOSS_MIN_STACK, 3);
+    fork1("Sleeper", Sleeper, "200000", USLOSS_MIN_STACK, 3);
+    for (i = 0; i < 3; i++) {
+        kidpid = join(&status);
+        sprintf(buf,"start1(): exit status for child %d is %d\n", kidpid, status); 
+        USLOSS_Console("%s", buf);
+    }
+    return 0;
+}
+
+int Sleeper(char *arg)
+{
+    int usec = atoi(arg), start, result;
+
+    USLOSS_Console("Sleeper(): %d sleeping for %d usec\n", getpid(), usec);
+    start = readtime();
+    result = sleepMe(usec);
+    USLOSS_Console("Sleeper(): %d woke, result %d, slept long enough = %d\n",
+                   getpid(), result, readtime() - start >= usec);
+    quit(-getpid());
+    return 0;
+}
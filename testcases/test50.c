@@ -0,0 +1,86 @@
+/* Tests getProcStats().
+ *
+ * start1 creates Mid at priority 3 and joins it.  Mid creates High at
+ * priority 2, which preempts Mid.  High sleeps for 100 milliseconds,
+ * letting Mid run and join it.  The switch counters and blocked times
+ * of all three show where each one spent its time.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <usloss.h>
+#include <phase1.h>
+
+int Mid(char *);
+int High(char *);
+void printStats(char *who, int pid);
+char buf[256];
+
+void test_setup(int argc, char *argv[])
+{
+}
+
+void test_cleanup(int argc, char *argv[])
+{
+}
+
+int start1(char *arg)
+{
+    int status, kidpid;
+    procStats stats;
+
+    USLOSS_Console("start1(): started\n");
+    USLOSS_Console("start1(): getProcStats(99) returned %d\n",
+                   getProcStats(99, &stats));
+    USLOSS_Console("start1(): getProcStats(NULL) returned %d\n",
+                   getProcStats(getpid(), NULL));
+    kidpid = fork1("Mid", Mid, NULL, USLOSS_MIN_STACK, 3);
+    join(&status);
+    sprintf(buf,"start1(): exit status for child %d is %d\n", kidpid, status); 
+    USLOSS_Console("%s", buf);
+    USLOSS_Console("start1(): getProcStats(%d) after join returned %d\n",
+                   kidpid, getProcStats(kidpid, &stats));
+    printStats("start1", getpid());
+    return 0;
+}
+
+int Mid(char *arg)
+{
+    int status, kidpid;
+    char pidbuf[10];
+
+    sprintf(pidbuf, "%d", getpid());
+    kidpid = fork1("High", High, pidbuf, USLOSS_MIN_STACK, 2);
+    USLOSS_Console("Mid(): back after High went to sleep\n");
+    join(&status);
+    sprintf(buf,"Mid(): exit status for child %d is %d\n", kidpid, status); 
+    USLOSS_Console("%s", buf);
+    printStats("Mid", getpid());
+    quit(-3);
+    return 0;
+}
+
+int High(char *arg)
+{
+    USLOSS_Console("High(): sleeping\n");
+    sleepMe(100000);
+    USLOSS_Console("High(): woke\n");
+    printStats("High", getpid());
+    printStats("High", atoi(arg));
+    quit(-2);
+    return 0;
+}
+
+void printStats(char *who, int pid)
+{
+    procStats stats;
+
+    getProcStats(pid, &stats);
+    USLOSS_Console("%s(): pid %d dispatches %d, voluntary %d, involuntary %d\n",
+                   who, pid, stats.dispatches, stats.voluntarySwitches,
+                   stats.involuntarySwitches);
+    USLOSS_Console("%s(): pid %d used cpu %d, blocked on join %d, zap %d, me %d, sync %d\n",
+                   who, pid, stats.cpuTime > 0, stats.joinBlockedTime > 0,
+                   stats.zapBlockedTime > 0, stats.meBlockedTime >= 100000,
+                   stats.syncBlockedTime > 0);
+}
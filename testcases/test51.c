@@ -0,0 +1,69 @@
+/* Tests that a deadlock among some processes is reported as soon as it
+ * forms, while the rest of the system keeps running.
+ *
+ * start1 creates A at priority 3 and Busy at priority 4.  A creates C at
+ * priority 2, which zaps A.  A then joins C, closing the cycle, which
+ * is reported right away.  Busy still runs and quits, and start1 joins
+ * it before waiting on A forever.
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+int A(char *);
+int C(char *);
+int Busy(char *);
+char buf[256];
+
+void test_setup(int argc, char *argv[])
+{
+}
+
+void test_cleanup(int argc, char *argv[])
+{
+}
+
+int start1(char *arg)
+{
+    int status, kidpid;
+
+    USLOSS_Console("start1(): started\n");
+    fork1("A", A, NULL, USLOSS_MIN_STACK, 3);
+    fork1("Busy", Busy, NULL, USLOSS_MIN_STACK, 4);
+    kidpid = join(&status);
+    sprintf(buf,"start1(): exit status for child %d is %d\n", kidpid, status); 
+    USLOSS_Console("%s", buf);
+    USLOSS_Console("start1(): joining A, which never quits\n");
+    kidpid = join(&status);
+    USLOSS_Console("start1(): should not see this message!\n");
+    return 0;
+}
+
+int A(char *arg)
+{
+    int status, kidpid;
+
+    fork1("C", C, NULL, USLOSS_MIN_STACK, 2);
+    USLOSS_Console("A(): joining C, which is zapping me\n");
+    kidpid = join(&status);
+    USLOSS_Console("A(): should not see this message! %d\n", kidpid);
+    quit(-3);
+    return 0;
+}
+
+int C(char *arg)
+{
+    USLOSS_Console("C(): zapping A\n");
+    zap(3);
+    USLOSS_Console("C(): should not see this message!\n");
+    quit(-4);
+    return 0;
+}
+
+int Busy(char *arg)
+{
+    USLOSS_Console("Busy(): still running\n");
+    quit(-5);
+    return 0;
+}
@@ -0,0 +1,53 @@
+/* Tests that zap() refuses to close a cycle of zaps.
+ *
+ * start1 creates A and B at priority 3.  A zaps B and blocks.  B then
+ * zaps A, which would leave both waiting on each other forever, so zap()
+ * returns -3 instead.  B quits, which completes A's zap.
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+int A(char *);
+int B(char *);
+char buf[256];
+
+void test_setup(int argc, char *argv[])
+{
+}
+
+void test_cleanup(int argc, char *argv[])
+{
+}
+
+int start1(char *arg)
+{
+    int i, status, kidpid;
+
+    USLOSS_Console("start1(): started\n");
+    fork1("A", A, NULL, USLOSS_MIN_STACK, 3);
+    fork1("B", B, NULL, USLOSS_MIN_STACK, 3);
+    for (i = 0; i < 2; i++) {
+        kidpid = join(&status);
+        sprintf(buf,"start1(): exit status for child %d is %d\n", kidpid, status); 
+        USLOSS_Console("%s", buf);
+    }
+    return 0;
+}
+
+int A(char *arg)
+{
+    USLOSS_Console("A(): zapping B\n");
+    USLOSS_Console("A(): zap(4) returned %d\n", zap(4));
+    quit(-3);
+    return 0;
+}
+
+int B(char *arg)
+{
+    USLOSS_Console("B(): zapping A\n");
+    USLOSS_Console("B(): zap(3) returned %d\n", zap(3));
+    quit(-4);
+    return 0;
+}
@@ -0,0 +1,118 @@
+/* Benchmarks the PSR reads and writes the kernel makes per fork/join
+ * cycle, with a child of higher and of lower priority than start1's,
+ * then per semV/semP and mutexLock/mutexUnlock pair, and per round of
+ * a semaphore ping-pong with Ponger that blocks both sides.
+ * Interrupts must be enabled again after each call.
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+#define CYCLES 100
+
+int Child(char *);
+int Ponger(char *);
+void cycles(int priority);
+void syncCycles(void);
+void report(char *what, int startReads, int startWrites, int enabled);
+int ping, pong;
+
+void test_setup(int argc, char *argv[])
+{
+}
+
+void test_cleanup(int argc, char *argv[])
+{
+}
+
+int start1(char *arg)
+{
+    USLOSS_Console("start1(): started\n");
+    cycles(2);
+    cycles(4);
+    syncCycles();
+    return 0;
+}
+
+void cycles(int priority)
+{
+    int i, status, reads, writes, startReads, startWrites, enabled = 1;
+
+    getPsrOps(&startReads, &startWrites);
+    for (i = 0; i < CYCLES; i++) {
+        fork1("Child", Child, NULL, USLOSS_MIN_STACK, priority);
+        enabled = enabled && (USLOSS_PsrGet() & USLOSS_PSR_CURRENT_INT);
+        join(&status);
+        enabled = enabled && (USLOSS_PsrGet() & USLOSS_PSR_CURRENT_INT);
+    }
+    getPsrOps(&reads, &writes);
+    USLOSS_Console("cycles(): child priority %d: %d PSR reads, %d writes per cycle\n",
+                   priority, (reads - startReads) / CYCLES,
+                   (writes - startWrites) / CYCLES);
+    USLOSS_Console("cycles(): interrupts enabled after every call = %d\n", enabled);
+}
+
+void syncCycles(void)
+{
+    int i, status, mutex, startReads, startWrites, enabled = 1;
+
+    ping = semCreate(0);
+    pong = semCreate(0);
+    mutex = mutexCreate(0);
+
+    getPsrOps(&startReads, &startWrites);
+    for (i = 0; i < CYCLES; i++) {
+        semV(ping);
+        semP(ping);
+        enabled = enabled && (USLOSS_PsrGet() & USLOSS_PSR_CURRENT_INT);
+    }
+    report("semV/semP", startReads, startWrites, enabled);
+
+    getPsrOps(&startReads, &startWrites);
+    for (i = 0; i < CYCLES; i++) {
+        mutexLock(mutex);
+        mutexUnlock(mutex);
+        enabled = enabled && (USLOSS_PsrGet() & USLOSS_PSR_CURRENT_INT);
+    }
+    report("mutexLock/mutexUnlock", startReads, startWrites, enabled);
+
+    fork1("Ponger", Ponger, NULL, USLOSS_MIN_STACK, 2);
+    getPsrOps(&startReads, &startWrites);
+    for (i = 0; i < CYCLES; i++) {
+        semV(ping);
+        semP(pong);
+        enabled = enabled && (USLOSS_PsrGet() & USLOSS_PSR_CURRENT_INT);
+    }
+    report("ping-pong", startReads, startWrites, enabled);
+    join(&status);
+}
+
+void report(char *what, int startReads, int startWrites, int enabled)
+{
+    int reads, writes;
+
+    getPsrOps(&reads, &writes);
+    USLOSS_Console("syncCycles(): %s: %d PSR reads, %d writes per cycle\n",
+                   what, (reads - startReads) / CYCLES,
+                   (writes - startWrites) / CYCLES);
+    USLOSS_Console("syncCycles(): interrupts enabled after every call = %d\n", enabled);
+}
+
+int Ponger(char *arg)
+{
+    int i;
+
+    for (i = 0; i < CYCLES; i++) {
+        semP(ping);
+        semV(pong);
+    }
+    quit(2);
+    return 0;
+}
+
+int Child(char *arg)
+{
+    quit(1);
+    return 0;
+}
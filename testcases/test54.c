@@ -0,0 +1,63 @@
+/* Tests the kernel trace ring.
+ *
+ * start1 creates Child at priority 3 and joins it.  Child zaps Sleeper,
+ * which sleeps for 40 milliseconds and quits.  start1 then reads back
+ * the trace and prints every event recorded since startup, without the
+ * times.
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+int Child(char *);
+int Sleeper(char *);
+char buf[256];
+
+void test_setup(int argc, char *argv[])
+{
+}
+
+void test_cleanup(int argc, char *argv[])
+{
+}
+
+int start1(char *arg)
+{
+    int i, n, status, kidpid;
+    traceRecord records[64];
+    char *events[] = {"?", "FORK", "QUIT", "SWITCH", "BLOCK", "WAKE", "ZAP",
+                      "TIMEOUT"};
+
+    USLOSS_Console("start1(): started\n");
+    fork1("Child", Child, NULL, USLOSS_MIN_STACK, 3);
+    kidpid = join(&status);
+    sprintf(buf,"start1(): exit status for child %d is %d\n", kidpid, status); 
+    USLOSS_Console("%s", buf);
+
+    n = readTrace(records, 64);
+    USLOSS_Console("start1(): %d trace records\n", n);
+    for (i = 0; i < n; i++) {
+        USLOSS_Console("start1(): %-7s pid %d arg %d\n",
+                       events[records[i].event], records[i].pid,
+                       records[i].arg);
+    }
+    return 0;
+}
+
+int Child(char *arg)
+{
+    int pid = fork1("Sleeper", Sleeper, NULL, USLOSS_MIN_STACK, 4);
+
+    zap(pid);
+    join(&pid);
+    quit(-3);
+    return 0;
+}
+
+int Sleeper(char *arg)
+{
+    sleepMe(40000);
+    quit(-4);
+    return 0;
+}
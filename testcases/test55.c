@@ -0,0 +1,81 @@
+/* Tests snapshotProcesses() and its CSV and JSON serializers.
+ *
+ * start1 creates Blocked, which blockMe()s, and Quitter, which quits
+ * and is not joined yet, and sleeps while they run.  start1 then takes
+ * a snapshot and prints it as CSV and JSON, with the cpu times cleared
+ * since they vary from run to run.  A buffer that is too small is
+ * reported with -2, and a status with no name is printed as a number.
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+int Blocked(char *);
+int Quitter(char *);
+char buf[256];
+char text[2048];
+
+void test_setup(int argc, char *argv[])
+{
+}
+
+void test_cleanup(int argc, char *argv[])
+{
+}
+
+int start1(char *arg)
+{
+    int i, n, status, kidpid, blocked;
+    procSnapshot procs[MAXPROC];
+
+    USLOSS_Console("start1(): started\n");
+    blocked = fork1("Blocked", Blocked, NULL, USLOSS_MIN_STACK, 2);
+    fork1("Quitter \"q\"", Quitter, NULL, USLOSS_MIN_STACK, 2);
+    sleepMe(20000);
+
+    USLOSS_Console("start1(): snapshotProcesses(NULL) returned %d\n",
+                   snapshotProcesses(NULL, MAXPROC));
+    USLOSS_Console("start1(): snapshotProcesses(procs, 2) returned %d\n",
+                   snapshotProcesses(procs, 2));
+    n = snapshotProcesses(procs, MAXPROC);
+    USLOSS_Console("start1(): snapshotProcesses(procs, MAXPROC) returned %d\n", n);
+    for (i = 0; i < n; i++) {
+        procs[i].cpuTime = 0;
+    }
+
+    USLOSS_Console("start1(): snapshotToCSV returned %d\n",
+                   snapshotToCSV(procs, n, text, sizeof(text)));
+    USLOSS_Console("%s", text);
+    USLOSS_Console("start1(): snapshotToJSON returned %d\n",
+                   snapshotToJSON(procs, n, text, sizeof(text)));
+    USLOSS_Console("%s", text);
+    USLOSS_Console("start1(): snapshotToJSON with a 64 byte buffer returned %d\n",
+                   snapshotToJSON(procs, n, text, 64));
+
+    procs[0].status = -1;
+    USLOSS_Console("start1(): snapshotToCSV with status -1 returned %d\n",
+                   snapshotToCSV(procs, 1, text, sizeof(text)));
+    USLOSS_Console("%s", text);
+
+    unblockProc(blocked);
+    for (i = 0; i < 2; i++) {
+        kidpid = join(&status);
+        sprintf(buf,"start1(): exit status for child %d is %d\n", kidpid, status); 
+        USLOSS_Console("%s", buf);
+    }
+    return 0;
+}
+
+int Blocked(char *arg)
+{
+    blockMe(11);
+    quit(-3);
+    return 0;
+}
+
+int Quitter(char *arg)
+{
+    quit(-4);
+    return 0;
+}
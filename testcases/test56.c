@@ -0,0 +1,67 @@
+/* Tests that a process quitting while it owns a mutex hands the mutex
+ * to its waiters.
+ *
+ * start1 creates a mutex and Holder at priority 3, which locks the
+ * mutex and sleeps.  start1 then creates Waiter at priority 2, which
+ * blocks on the mutex.  Holder quits without unlocking it: Waiter gets
+ * the mutex and unlocks it, and start1 can lock it again after joining
+ * both.
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+int Holder(char *);
+int Waiter(char *);
+char buf[256];
+int mutex;
+
+void test_setup(int argc, char *argv[])
+{
+}
+
+void test_cleanup(int argc, char *argv[])
+{
+}
+
+int start1(char *arg)
+{
+    int i, status, kidpid;
+
+    USLOSS_Console("start1(): started\n");
+    mutex = mutexCreate(0);
+
+    fork1("Holder", Holder, NULL, USLOSS_MIN_STACK, 3);
+    sleepMe(20000);
+    fork1("Waiter", Waiter, NULL, USLOSS_MIN_STACK, 2);
+
+    for (i = 0; i < 2; i++) {
+        kidpid = join(&status);
+        sprintf(buf, "start1(): exit status for child %d is %d\n", kidpid, status);
+        USLOSS_Console("%s", buf);
+    }
+
+    USLOSS_Console("start1(): mutexLock returned %d\n", mutexLock(mutex));
+    USLOSS_Console("start1(): mutexUnlock returned %d\n", mutexUnlock(mutex));
+    quit(0);
+    return 0; /* so gcc will not complain about its absence... */
+}
+
+int Holder(char *arg)
+{
+    USLOSS_Console("Holder(): mutexLock returned %d\n", mutexLock(mutex));
+    sleepMe(40000);
+    USLOSS_Console("Holder(): quitting while owning the mutex\n");
+    quit(3);
+    return 0;
+}
+
+int Waiter(char *arg)
+{
+    USLOSS_Console("Waiter(): locking the mutex\n");
+    USLOSS_Console("Waiter(): mutexLock returned %d\n", mutexLock(mutex));
+    USLOSS_Console("Waiter(): mutexUnlock returned %d\n", mutexUnlock(mutex));
+    quit(4);
+    return 0;
+}
@@ -0,0 +1,116 @@
+/* Tests that the per-status counts in the dumpProcesses() summary line
+ * follow the process table as processes block, quit and are reaped.
+ *
+ * start1 creates Blocker, which blockMe()s, Quitter, which quits,
+ * Parent, which joins on Sleeper, a child that sleeps, and Zapper,
+ * which zaps Blocker.  Before the children run, once they have all
+ * blocked or quit, and once start1 has reaped them, start1 counts the
+ * statuses in a snapshot of the table and prints them in the form of
+ * the summary line, followed by dumpStatusCounts().  The table is
+ * printed without CPU times, which vary from run to run.
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+int Blocker(char *);
+int Quitter(char *);
+int Parent(char *);
+int Sleeper(char *);
+int Zapper(char *);
+void showCounts(char *when);
+char buf[256];
+int blocker;
+
+void test_setup(int argc, char *argv[])
+{
+}
+
+void test_cleanup(int argc, char *argv[])
+{
+}
+
+int start1(char *arg)
+{
+    int i, status, kidpid;
+
+    USLOSS_Console("start1(): started\n");
+    blocker = fork1("Blocker", Blocker, NULL, USLOSS_MIN_STACK, 3);
+    fork1("Quitter", Quitter, NULL, USLOSS_MIN_STACK, 3);
+    fork1("Parent", Parent, NULL, USLOSS_MIN_STACK, 3);
+    fork1("Zapper", Zapper, NULL, USLOSS_MIN_STACK, 4);
+    showCounts("after forking");
+
+    sleepMe(20000);
+    showCounts("once the children blocked or quit");
+
+    unblockProc(blocker);
+    for (i = 0; i < 4; i++) {
+        kidpid = join(&status);
+        sprintf(buf, "start1(): exit status for child %d is %d\n", kidpid, status);
+        USLOSS_Console("%s", buf);
+    }
+    showCounts("after reaping");
+
+    quit(0);
+    return 0; /* so gcc will not complain about its absence... */
+}
+
+/* Prints a snapshot of the table and its status counts in the form of
+   dumpStatusCounts(), then dumpStatusCounts() itself */
+void showCounts(char *when)
+{
+    int i, n, counts[MEBLOCKED + 1] = {0};
+    procSnapshot procs[MAXPROC];
+
+    n = snapshotProcesses(procs, MAXPROC);
+    for (i = 0; i < n; i++) {
+        counts[procs[i].status > MEBLOCKED ? MEBLOCKED : procs[i].status]++;
+    }
+    USLOSS_Console("start1(): table %s:\n", when);
+    for (i = 0; i < n; i++) {
+        USLOSS_Console("%5d %10s %4d\n", procs[i].pid, procs[i].name, procs[i].status);
+    }
+    USLOSS_Console("READY %d, RUNNING %d, JOINBLOCKED %d, ZAPBLOCKED %d, MEBLOCKED %d, OTHER BLOCKED %d, QUIT %d\n",
+                   counts[READY], counts[RUNNING], counts[JOINBLOCKED], counts[ZAPBLOCKED], counts[MEBLOCKED],
+                   counts[WAITBLOCKED] + counts[SYNCBLOCKED] + counts[SLEEPBLOCKED], counts[QUIT]);
+    dumpStatusCounts();
+}
+
+int Blocker(char *arg)
+{
+    blockMe(11);
+    quit(1);
+    return 0;
+}
+
+int Quitter(char *arg)
+{
+    quit(2);
+    return 0;
+}
+
+int Parent(char *arg)
+{
+    int status;
+
+    fork1("Sleeper", Sleeper, NULL, USLOSS_MIN_STACK, 3);
+    join(&status);
+    quit(3);
+    return 0;
+}
+
+int Sleeper(char *arg)
+{
+    sleepMe(100000);
+    quit(5);
+    return 0;
+}
+
+int Zapper(char *arg)
+{
+    zap(blocker);
+    quit(4);
+    return 0;
+}
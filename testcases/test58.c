@@ -0,0 +1,59 @@
+/* Tests that zapAsync() refuses a zap whose handle zapWait() would have
+ * no room to report.
+ *
+ * start1 repeatedly creates a Worker at priority 3, zaps it with
+ * zapAsync() and joins it, without calling zapWait().  Once MAXPROC
+ * handles are waiting to be collected, zapAsync() returns -3.  After
+ * zapWait(ZAP_WAIT_ALL) collects them all, zapAsync() works again.
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+int Worker(char *);
+char buf[256];
+
+void test_setup(int argc, char *argv[])
+{
+}
+
+void test_cleanup(int argc, char *argv[])
+{
+}
+
+/* Forks a Worker, zaps it and joins it, returning what zapAsync() did */
+int zapOne(void)
+{
+    int pid, result, status;
+
+    pid = fork1("Worker", Worker, NULL, USLOSS_MIN_STACK, 3);
+    result = zapAsync(pid);
+    join(&status);
+    return result;
+}
+
+int start1(char *arg)
+{
+    int i, result;
+
+    USLOSS_Console("start1(): started\n");
+    for (i = 0; i < MAXPROC; i++) {
+        result = zapOne();
+        if (result < 0) {
+            USLOSS_Console("start1(): zapAsync %d returned %d\n", i, result);
+        }
+    }
+    USLOSS_Console("start1(): zapAsync %d returned %d\n", i, zapOne());
+    USLOSS_Console("start1(): zapWait(ZAP_WAIT_ALL) returned %d\n", zapWait(ZAP_WAIT_ALL));
+    result = zapOne();
+    USLOSS_Console("start1(): zapAsync after zapWait returned %d\n", result > 0);
+    USLOSS_Console("start1(): zapWait(ZAP_WAIT_ANY) returned %d\n", zapWait(ZAP_WAIT_ANY) == result);
+    return 0;
+}
+
+int Worker(char *arg)
+{
+    quit(0);
+    return 0;
+}